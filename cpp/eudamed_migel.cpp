@@ -1,7 +1,8 @@
 // eudamed_migel.cpp — Match EUDAMED devices against Swiss MiGeL codes
-// Build: g++ -std=c++20 -O2 -pthread cpp/eudamed_migel.cpp -lsqlite3 -o eudamed_migel
-// Usage: ./eudamed_migel --db1 db/eudamed_devices.db --db2 db/eudamed_full_with_urls.db \
-//          --migel-de xlsx/migel_0.csv --migel-fr xlsx/migel_1.csv --migel-it xlsx/migel_2.csv
+// Build: g++ -std=c++20 -O2 -pthread cpp/eudamed_migel.cpp -lsqlite3 -lz -o eudamed_migel
+// Usage: ./eudamed_migel --db1 db/eudamed_devices.db --db2 db/eudamed_full_with_urls.db
+//          --migel-xlsx xlsx/migel.xlsx
+//    or: ... --migel-de xlsx/migel_0.csv --migel-fr xlsx/migel_1.csv --migel-it xlsx/migel_2.csv
 
 #include <iostream>
 #include <string>
@@ -16,7 +17,8 @@
 #include <mutex>
 #include <atomic>
 #include <sqlite3.h>
-#include "migel.hpp"
+#include "migel_snapshot.hpp"
+#include "migel_xlsx.hpp"
 
 // ----------------------------- English→DE/FR/IT medical term map ---------------
 // EUDAMED tradeNames are often in English. MiGeL keywords are in DE/FR/IT.
@@ -126,17 +128,19 @@ static const std::unordered_map<std::string, std::string>& english_medical_terms
 }
 
 /// Expand English medical terms in a tradeName to include DE/FR/IT equivalents.
-static std::string expand_english_terms(const std::string& text) {
-    std::string lower = migel::to_lower(text);
+/// lower and expanded are caller-owned buffers (reused across devices).
+static void expand_english_terms(const std::string& text, std::string& lower, std::string& expanded) {
+    lower.assign(text);
+    for (auto& c : lower) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
     const auto& terms = english_medical_terms();
-    std::string expanded = text;
+    expanded.assign(text);
 
     for (const auto& [en, translations] : terms) {
         if (lower.find(en) != std::string::npos) {
-            expanded += " " + translations;
+            expanded += ' ';
+            expanded += translations;
         }
     }
-    return expanded;
 }
 
 // ----------------------------- Helpers ---------------------------------------
@@ -168,6 +172,13 @@ struct Args {
     std::string migel_de;
     std::string migel_fr;
     std::string migel_it;
+    std::string migel_xlsx; // MiGeL workbook, read directly instead of the CSVs
+    std::string snapshot; // optional catalog snapshot, see migel_snapshot.hpp
+    std::string lang_cache; // optional side file of language detection results
+    size_t top_k = 0; // > 0: record the top-K candidate scores for offline tuning
+    double trigram_overlap = 0.0; // > 0: trigram candidate prefilter with this minimum overlap
+    bool stem = false;            // match light-stemmed words instead of truncations
+    bool decompound = false;      // also match the parts of German compound words
     int threads = 0; // 0 = auto-detect
 };
 
@@ -180,19 +191,41 @@ static Args parse_args(int argc, char* argv[]) {
         else if (arg == "--migel-de" && i + 1 < argc) args.migel_de = argv[++i];
         else if (arg == "--migel-fr" && i + 1 < argc) args.migel_fr = argv[++i];
         else if (arg == "--migel-it" && i + 1 < argc) args.migel_it = argv[++i];
+        else if (arg == "--migel-xlsx" && i + 1 < argc) args.migel_xlsx = argv[++i];
+        else if (arg == "--snapshot" && i + 1 < argc) args.snapshot = argv[++i];
+        else if (arg == "--lang-cache" && i + 1 < argc) args.lang_cache = argv[++i];
+        else if (arg == "--stem") args.stem = true;
+        else if (arg == "--decompound") args.decompound = true;
+        else if (arg == "--trigram-overlap" && i + 1 < argc) args.trigram_overlap = std::stod(argv[++i]);
+        else if (arg == "--top-k" && i + 1 < argc) args.top_k = std::stoul(argv[++i]);
         else if (arg == "--threads" && i + 1 < argc) args.threads = std::stoi(argv[++i]);
         else if (arg == "-h" || arg == "--help") {
             std::cout << "Usage: " << argv[0]
-                      << " --db1 <db> --db2 <db> --migel-de <csv> --migel-fr <csv> --migel-it <csv> [--threads N]\n"
+                      << " --db1 <db> --db2 <db> (--migel-xlsx <xlsx> | --migel-de <csv> --migel-fr <csv> --migel-it <csv>) [--snapshot <file>] [--lang-cache <file>] [--top-k K] [--trigram-overlap X] [--stem] [--decompound] [--threads N]\n"
                       << "\nMerges two EUDAMED SQLite DBs, matches devices against MiGeL codes,\n"
                       << "and outputs db/eudamed_migel_DD.MM.YYYY.db with matched products.\n"
-                      << "\nGenerate CSVs from XLSX with:\n"
+                      << "\n--migel-xlsx reads the DE, FR and IT sheets straight from the MiGeL workbook.\n"
+                      << "--snapshot maps the compiled catalog from <file>, (re)writing it from the\n"
+                      << "workbook or CSVs when it is missing or they have changed.\n"
+                      << "--lang-cache loads detected field languages from <file> and saves them back\n"
+                      << "after matching, so repeated field texts skip detection in later runs.\n"
+                      << "--top-k also writes the K best candidates per device text with their per-language\n"
+                      << "scores to the migel_candidates table, for replay with migel_tune.\n"
+                      << "--trigram-overlap scores prefiltered candidates one by one (pruned scoring) with\n"
+                      << "the trigram candidate prefilter (X = minimum share of a keyword's trigrams in one\n"
+                      << "word, 0 < X <= 1) instead of the sparse column scorer; results are identical,\n"
+                      << "see migel_bench.\n"
+                      << "--stem compares light-stemmed DE/FR/IT words (plural/case endings) instead of\n"
+                      << "retrying German keywords truncated by one char; this changes the matches.\n"
+                      << "--decompound splits German compound words into catalog keywords and counts\n"
+                      << "every part as a hit, not only the final one; this changes the matches.\n"
+                      << "\nOr generate CSVs from XLSX with:\n"
                       << "  ssconvert --export-type=Gnumeric_stf:stf_csv --export-file-per-sheet xlsx/migel.xlsx xlsx/migel_%n.csv\n";
             exit(0);
         }
     }
-    if (args.db1.empty() || args.db2.empty() || args.migel_de.empty()) {
-        std::cerr << "Error: --db1, --db2, and --migel-de are required.\n"
+    if (args.db1.empty() || args.db2.empty() || (args.migel_de.empty() && args.migel_xlsx.empty())) {
+        std::cerr << "Error: --db1, --db2, and --migel-xlsx or --migel-de are required.\n"
                   << "Run with --help for usage.\n";
         exit(1);
     }
@@ -296,18 +329,132 @@ struct MatchResult {
     std::string migel_lim;
 };
 
+// ----------------------------- Match memoization ------------------------------
+
+/// The fields that determine a device's match. EUDAMED lists long runs of variants
+/// (sizes, colours) with identical text; those share one key and are matched once.
+struct TextKey {
+    std::string_view trade_name;
+    std::string_view description;
+    std::string_view cnd_desc;
+    std::string_view manufacturer;
+
+    bool operator==(const TextKey&) const = default;
+};
+
+struct TextKeyHash {
+    size_t operator()(const TextKey& k) const {
+        std::hash<std::string_view> h;
+        size_t seed = h(k.trade_name);
+        for (std::string_view f : {k.description, k.cnd_desc, k.manufacturer})
+            seed ^= h(f) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+        return seed;
+    }
+};
+
+/// Outcome of matching one distinct text tuple.
+enum class TupleStatus : uint8_t { MATCHED, NO_MATCH, SKIPPED_EMPTY, SKIPPED_LANG };
+
+// ----------------------------- Candidate score export -------------------------
+
+/// Write the recorded top-K candidates of every matched tuple (migel_candidates, in
+/// rank order) and the devices sharing each tuple (migel_candidate_devices), so
+/// migel_tune can replay other PassCriteria without re-reading the device text.
+static void write_candidate_tables(
+    sqlite3* db,
+    size_t top_k,
+    const std::vector<std::pair<std::string, Row>>& device_vec,
+    const std::vector<uint32_t>& tuple_of,
+    const std::vector<TupleStatus>& tuple_status,
+    const std::vector<std::vector<migel::CandidateScore>>& tuple_top,
+    const std::vector<migel::MigelItem>& migel_items)
+{
+    sqlite3_exec(db,
+        "CREATE TABLE migel_candidates_meta (top_k INTEGER);"
+        "CREATE TABLE migel_candidates (tuple INTEGER, rank INTEGER, migel_position_nr TEXT,"
+        " score_de REAL, max_len_de INTEGER, count_de INTEGER,"
+        " score_fr REAL, max_len_fr INTEGER, count_fr INTEGER,"
+        " score_it REAL, max_len_it INTEGER, count_it INTEGER);"
+        "CREATE TABLE migel_candidate_devices (uuid TEXT, tuple INTEGER);",
+        nullptr, nullptr, nullptr);
+
+    sqlite3_stmt* meta = nullptr;
+    sqlite3_prepare_v2(db, "INSERT INTO migel_candidates_meta VALUES (?)", -1, &meta, nullptr);
+    sqlite3_bind_int64(meta, 1, static_cast<sqlite3_int64>(top_k));
+    sqlite3_step(meta);
+    sqlite3_finalize(meta);
+
+    sqlite3_stmt* cand = nullptr;
+    sqlite3_prepare_v2(db, "INSERT INTO migel_candidates VALUES (?,?,?,?,?,?,?,?,?,?,?,?)", -1, &cand, nullptr);
+    for (size_t t = 0; t < tuple_top.size(); ++t) {
+        for (size_t r = 0; r < tuple_top[t].size(); ++r) {
+            const auto& c = tuple_top[t][r];
+            sqlite3_reset(cand);
+            sqlite3_bind_int64(cand, 1, static_cast<sqlite3_int64>(t));
+            sqlite3_bind_int64(cand, 2, static_cast<sqlite3_int64>(r));
+            sqlite3_bind_text(cand, 3, migel_items[c.item].position_nr.c_str(), -1, SQLITE_STATIC);
+            for (int l = 0; l < 3; ++l) {
+                sqlite3_bind_double(cand, 4 + l * 3, c.lang[l].score);
+                sqlite3_bind_int64(cand, 5 + l * 3, static_cast<sqlite3_int64>(c.lang[l].max_len));
+                sqlite3_bind_int64(cand, 6 + l * 3, static_cast<sqlite3_int64>(c.lang[l].count));
+            }
+            if (sqlite3_step(cand) != SQLITE_DONE)
+                std::cerr << "INSERT error: " << sqlite3_errmsg(db) << "\n";
+        }
+    }
+    sqlite3_finalize(cand);
+
+    sqlite3_stmt* dev = nullptr;
+    sqlite3_prepare_v2(db, "INSERT INTO migel_candidate_devices VALUES (?,?)", -1, &dev, nullptr);
+    for (size_t i = 0; i < device_vec.size(); ++i) {
+        TupleStatus status = tuple_status[tuple_of[i]];
+        if (status != TupleStatus::MATCHED && status != TupleStatus::NO_MATCH) continue;
+        sqlite3_reset(dev);
+        sqlite3_bind_text(dev, 1, device_vec[i].first.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(dev, 2, tuple_of[i]);
+        if (sqlite3_step(dev) != SQLITE_DONE)
+            std::cerr << "INSERT error: " << sqlite3_errmsg(db) << "\n";
+    }
+    sqlite3_finalize(dev);
+    sqlite3_exec(db, "CREATE INDEX idx_migel_candidates_tuple ON migel_candidates(tuple)",
+                 nullptr, nullptr, nullptr);
+}
+
 // ----------------------------- Main ------------------------------------------
 
 int main(int argc, char* argv[]) {
     auto args = parse_args(argc, argv);
 
-    // Step 1: Load MiGeL items from CSV files
-    std::cout << "Loading MiGeL items from CSVs ...\n";
-    auto migel_items = migel::parse_migel_items(args.migel_de, args.migel_fr, args.migel_it);
-    std::cout << "   " << migel_items.size() << " MiGeL items loaded.\n";
-
-    auto keyword_index = migel::build_keyword_index(migel_items);
-    std::cout << "   " << keyword_index.size() << " unique keywords indexed.\n";
+    // Step 1: Load MiGeL items from the workbook or CSV files (or their snapshot)
+    migel::CatalogSource source;
+    migel::MigelCatalog migel_catalog;
+    if (!args.migel_xlsx.empty()) {
+        std::cout << "Loading MiGeL items from " << args.migel_xlsx << " ...\n";
+        migel_catalog = migel::load_catalog({args.migel_xlsx}, args.snapshot, &source, [&] {
+            migel::TokenDict tokens;
+            auto items = migel::parse_migel_xlsx(tokens, args.migel_xlsx);
+            return migel::build_catalog(std::move(items), tokens);
+        });
+    } else {
+        std::cout << "Loading MiGeL items from CSVs ...\n";
+        migel_catalog = migel::load_catalog(args.migel_de, args.migel_fr, args.migel_it, args.snapshot, &source);
+    }
+    const auto& migel_items = migel_catalog.items;
+    const auto& catalog = migel_catalog.catalog;
+    const auto& keyword_index = migel_catalog.index;
+    const char* input = args.migel_xlsx.empty() ? "CSVs" : "workbook";
+    if (source == migel::CatalogSource::SNAPSHOT) {
+        std::cout << "   Mapped snapshot " << args.snapshot << " of the " << input << "\n";
+    } else {
+        std::cout << "   Parsed the " << input << "\n";
+        if (source == migel::CatalogSource::SOURCE_SNAPSHOT_WRITTEN)
+            std::cout << "   Wrote snapshot " << args.snapshot << "\n";
+        else if (!args.snapshot.empty())
+            std::cerr << "   Warning: could not write snapshot " << args.snapshot << "\n";
+    }
+    std::cout << "   " << migel_items.size() << " MiGeL items loaded, "
+              << catalog.token_len.size() << " distinct keyword tokens.\n";
+    std::cout << "   " << keyword_index.size() << " keywords indexed (DE/FR/IT sheets).\n";
 
     // Step 2: Read column headers from both DBs and build unified column list
     sqlite3* tmp_db1 = nullptr;
@@ -371,66 +518,144 @@ int main(int argc, char* argv[]) {
         device_vec.emplace_back(std::move(uuid), std::move(row));
     all_rows.clear(); // free memory
 
-    // Step 5: Parallel matching
+    // Step 5: Group devices by text tuple, match each distinct tuple in parallel
+    static const std::string empty;
+    auto field_of = [&](const Row& row, size_t idx) -> const std::string& {
+        return idx < row.size() ? row[idx] : empty;
+    };
+
+    std::vector<uint32_t> tuple_of(device_vec.size());
+    std::vector<size_t> tuple_device; // first device carrying each distinct tuple
+    {
+        std::unordered_map<TextKey, uint32_t, TextKeyHash> tuple_ids;
+        tuple_ids.reserve(device_vec.size());
+        for (size_t i = 0; i < device_vec.size(); ++i) {
+            const Row& row = device_vec[i].second;
+            TextKey key{field_of(row, tradeName_idx), field_of(row, description_idx),
+                        field_of(row, cnd_description_idx), field_of(row, mfr_idx)};
+            auto [it, inserted] = tuple_ids.try_emplace(key, static_cast<uint32_t>(tuple_device.size()));
+            if (inserted) tuple_device.push_back(i);
+            tuple_of[i] = it->second;
+        }
+    }
+
     unsigned int num_threads = args.threads > 0
         ? static_cast<unsigned int>(args.threads)
         : std::max(2u, std::thread::hardware_concurrency());
-    std::cout << "Matching " << device_vec.size() << " devices against MiGeL using "
-              << num_threads << " threads ...\n";
-
-    std::vector<std::vector<MatchResult>> thread_results(num_threads);
+    std::cout << "Matching " << device_vec.size() << " devices (" << tuple_device.size()
+              << " distinct text tuples) against MiGeL using " << num_threads << " threads ...\n";
+
+    // Field text -> detected language, shared by all workers
+    migel::LangCache lang_cache;
+    if (!args.lang_cache.empty())
+        std::cout << "   Loaded " << lang_cache.load(args.lang_cache) << " cached field languages from "
+                  << args.lang_cache << "\n";
+
+    std::vector<TupleStatus> tuple_status(tuple_device.size(), TupleStatus::NO_MATCH);
+    std::vector<const migel::MigelItem*> tuple_match(tuple_device.size(), nullptr);
+    std::vector<std::vector<migel::CandidateScore>> tuple_top(args.top_k ? tuple_device.size() : 0);
     std::atomic<size_t> processed{0};
-    std::atomic<size_t> skipped_empty{0};
-    std::atomic<size_t> skipped_lang{0};
 
-    auto worker = [&](unsigned int tid, size_t start, size_t end) {
-        auto& results = thread_results[tid];
-        for (size_t i = start; i < end; ++i) {
-            auto& [uuid, row] = device_vec[i];
+    auto count_processed = [&](size_t n) {
+        size_t before = processed.fetch_add(n, std::memory_order_relaxed);
+        size_t after = before + n;
+        for (size_t p = (before / 200000 + 1) * 200000; p <= after; p += 200000)
+            std::cout << "   Processed: " << p << " / " << tuple_device.size() << "\n" << std::flush;
+    };
 
-            std::string trade_name = (tradeName_idx < row.size()) ? row[tradeName_idx] : "";
+    auto worker = [&](size_t start, size_t end) {
+        // Per-thread buffers, reused for every tuple
+        std::string desc_de, desc_fr, desc_it, en_lower, en_expanded;
+        migel::NormalizedText lang_scratch;
+        migel::Matcher matcher(migel_items, catalog, keyword_index);
+        if (args.trigram_overlap > 0) {
+            matcher.set_scoring(migel::Scoring::PRUNED);
+            matcher.set_prefilter(migel::Prefilter::TRIGRAM, args.trigram_overlap);
+        }
+        if (args.stem) matcher.set_morphology(migel::Morphology::STEM);
+        if (args.decompound) matcher.set_decompounding(true);
+
+        // Routed tuples are matched in batches; their channel text is packed into
+        // batch_text and only turned into views once the batch is complete.
+        constexpr size_t BATCH = 1024;
+        struct Pending { size_t tuple; size_t offset[3]; size_t len[3]; };
+        std::string batch_text;
+        std::vector<Pending> pending;
+        std::vector<migel::DeviceText> batch;
+        std::vector<migel::MatchOutcome> outcomes;
+        std::vector<migel::CandidateScore> top;
+        pending.reserve(BATCH);
+        batch.reserve(BATCH);
+        outcomes.resize(BATCH);
+
+        auto flush = [&]() {
+            batch.clear();
+            for (const auto& pd : pending) {
+                std::string_view text(batch_text);
+                batch.push_back({text.substr(pd.offset[0], pd.len[0]),
+                                 text.substr(pd.offset[1], pd.len[1]),
+                                 text.substr(pd.offset[2], pd.len[2]),
+                                 field_of(device_vec[tuple_device[pd.tuple]].second, mfr_idx)});
+            }
+            matcher.match_batch(batch, outcomes);
+            for (size_t k = 0; k < pending.size(); ++k) {
+                if (outcomes[k].item) {
+                    tuple_status[pending[k].tuple] = TupleStatus::MATCHED;
+                    tuple_match[pending[k].tuple] = outcomes[k].item;
+                }
+                if (args.top_k) {
+                    matcher.score_top_k(batch[k], args.top_k, top);
+                    tuple_top[pending[k].tuple].assign(top.begin(), top.end());
+                }
+            }
+            count_processed(pending.size());
+            pending.clear();
+            batch_text.clear();
+        };
 
-            std::string description = (description_idx < row.size()) ? row[description_idx] : "";
-            std::string cnd_desc = (cnd_description_idx < row.size()) ? row[cnd_description_idx] : "";
-            std::string mfr_name = (mfr_idx < row.size()) ? row[mfr_idx] : "";
+        for (size_t t = start; t < end; ++t) {
+            const Row& row = device_vec[tuple_device[t]].second;
+
+            const std::string& trade_name = field_of(row, tradeName_idx);
+            const std::string& description = field_of(row, description_idx);
+            const std::string& cnd_desc = field_of(row, cnd_description_idx);
 
             if (trade_name.empty() && description.empty() && cnd_desc.empty()) {
-                skipped_empty.fetch_add(1, std::memory_order_relaxed);
-                size_t p = processed.fetch_add(1, std::memory_order_relaxed) + 1;
-                if (p % 200000 == 0)
-                    std::cout << "   Processed: " << p << " / " << device_vec.size() << "\n" << std::flush;
+                tuple_status[t] = TupleStatus::SKIPPED_EMPTY;
+                count_processed(1);
                 continue;
             }
 
             // Per-field language detection and routing
             // UNKNOWN = unsupported language (Latvian, Polish, etc.) → skip field
-            std::string desc_de, desc_fr, desc_it;
+            desc_de.clear();
+            desc_fr.clear();
+            desc_it.clear();
+
+            auto append = [](std::string& desc, const std::string& text) {
+                if (!desc.empty()) desc += ' ';
+                desc += text;
+            };
 
             auto route_field = [&](const std::string& field) {
                 if (field.empty()) return;
-                auto det = migel::detect_language(field);
+                auto det = lang_cache.detect(field, lang_scratch);
                 switch (det.lang) {
                     case migel::Lang::DE:
-                        if (!desc_de.empty()) desc_de += " ";
-                        desc_de += field;
+                        append(desc_de, field);
                         break;
                     case migel::Lang::FR:
-                        if (!desc_fr.empty()) desc_fr += " ";
-                        desc_fr += field;
+                        append(desc_fr, field);
                         break;
                     case migel::Lang::IT:
-                        if (!desc_it.empty()) desc_it += " ";
-                        desc_it += field;
+                        append(desc_it, field);
                         break;
                     case migel::Lang::EN: {
                         // EN: expand to DE/FR/IT and add to all three channels
-                        std::string expanded = expand_english_terms(field);
-                        if (!desc_de.empty()) desc_de += " ";
-                        desc_de += expanded;
-                        if (!desc_fr.empty()) desc_fr += " ";
-                        desc_fr += expanded;
-                        if (!desc_it.empty()) desc_it += " ";
-                        desc_it += expanded;
+                        expand_english_terms(field, en_lower, en_expanded);
+                        append(desc_de, en_expanded);
+                        append(desc_fr, en_expanded);
+                        append(desc_it, en_expanded);
                         break;
                     }
                     case migel::Lang::UNKNOWN:
@@ -443,60 +668,78 @@ int main(int argc, char* argv[]) {
             route_field(description);
             route_field(cnd_desc);
 
-            // Skip device if no supported-language text remains
+            // Skip tuple if no supported-language text remains
             if (desc_de.empty() && desc_fr.empty() && desc_it.empty()) {
-                skipped_lang.fetch_add(1, std::memory_order_relaxed);
-                size_t p = processed.fetch_add(1, std::memory_order_relaxed) + 1;
-                if (p % 200000 == 0)
-                    std::cout << "   Processed: " << p << " / " << device_vec.size() << "\n" << std::flush;
+                tuple_status[t] = TupleStatus::SKIPPED_LANG;
+                count_processed(1);
                 continue;
             }
 
-            const migel::MigelItem* match = migel::find_best_migel_match(
-                desc_de, desc_fr, desc_it, mfr_name,
-                migel_items, keyword_index);
-
-            if (match) {
-                results.push_back({row, match->position_nr, match->bezeichnung, match->limitation});
+            Pending pd{t, {}, {}};
+            const std::string* descs[3] = {&desc_de, &desc_fr, &desc_it};
+            for (int l = 0; l < 3; ++l) {
+                pd.offset[l] = batch_text.size();
+                pd.len[l] = descs[l]->size();
+                batch_text += *descs[l];
             }
-
-            size_t p = processed.fetch_add(1, std::memory_order_relaxed) + 1;
-            if (p % 200000 == 0)
-                std::cout << "   Processed: " << p << " / " << device_vec.size() << "\n" << std::flush;
+            pending.push_back(pd);
+            if (pending.size() == BATCH) flush();
         }
+        flush();
     };
 
     // Launch threads with equal work distribution
     std::vector<std::thread> threads;
-    size_t chunk = device_vec.size() / num_threads;
-    size_t remainder = device_vec.size() % num_threads;
+    size_t chunk = tuple_device.size() / num_threads;
+    size_t remainder = tuple_device.size() % num_threads;
     size_t offset = 0;
 
     for (unsigned int t = 0; t < num_threads; ++t) {
         size_t start = offset;
         size_t end = offset + chunk + (t < remainder ? 1 : 0);
         offset = end;
-        threads.emplace_back(worker, t, start, end);
+        threads.emplace_back(worker, start, end);
     }
 
     for (auto& t : threads) t.join();
 
-    // Merge results
+    // Fan tuple outcomes back out to every device, in device order
     std::vector<MatchResult> all_matches;
-    size_t total_matched = 0;
-    for (auto& tr : thread_results) total_matched += tr.size();
-    all_matches.reserve(total_matched);
-    for (auto& tr : thread_results) {
-        all_matches.insert(all_matches.end(),
-                           std::make_move_iterator(tr.begin()),
-                           std::make_move_iterator(tr.end()));
+    size_t skipped_empty = 0;
+    size_t skipped_lang = 0;
+    for (size_t i = 0; i < device_vec.size(); ++i) {
+        uint32_t t = tuple_of[i];
+        switch (tuple_status[t]) {
+            case TupleStatus::MATCHED: {
+                const migel::MigelItem* match = tuple_match[t];
+                all_matches.push_back({device_vec[i].second, match->position_nr,
+                                       match->bezeichnung, match->limitation});
+                break;
+            }
+            case TupleStatus::NO_MATCH:
+                break;
+            case TupleStatus::SKIPPED_EMPTY:
+                ++skipped_empty;
+                break;
+            case TupleStatus::SKIPPED_LANG:
+                ++skipped_lang;
+                break;
+        }
     }
 
     std::cout << "\nMatching complete:\n"
               << "   Total devices: " << device_vec.size() << "\n"
-              << "   Skipped (no text fields): " << skipped_empty.load() << "\n"
-              << "   Skipped (unsupported language): " << skipped_lang.load() << "\n"
+              << "   Skipped (no text fields): " << skipped_empty << "\n"
+              << "   Skipped (unsupported language): " << skipped_lang << "\n"
               << "   Matched to MiGeL: " << all_matches.size() << "\n";
+    auto lang_stats = lang_cache.stats();
+    size_t lookups = lang_stats.hits + lang_stats.misses;
+    std::cout << "   Language cache: " << lang_stats.hits << " / " << lookups << " field lookups hit ("
+              << std::fixed << std::setprecision(1)
+              << (lookups ? 100.0 * static_cast<double>(lang_stats.hits) / static_cast<double>(lookups) : 0.0)
+              << "%), " << lang_stats.entries << " entries\n" << std::defaultfloat;
+    if (!args.lang_cache.empty() && !lang_cache.save(args.lang_cache))
+        std::cerr << "   Warning: could not write language cache " << args.lang_cache << "\n";
 
     // Step 6: Write output database
     std::vector<std::string> output_cols = unified_cols;
@@ -575,6 +818,9 @@ int main(int argc, char* argv[]) {
             std::cerr << "INSERT error: " << sqlite3_errmsg(out_db) << "\n";
     }
 
+    if (args.top_k)
+        write_candidate_tables(out_db, args.top_k, device_vec, tuple_of, tuple_status, tuple_top, migel_items);
+
     sqlite3_exec(out_db, "COMMIT;", nullptr, nullptr, nullptr);
     sqlite3_finalize(stmt);
     sqlite3_close(out_db);
@@ -2,6 +2,7 @@
 // No external dependencies — reads CSV files produced by ssconvert from gnumeric.
 // Usage: ssconvert --export-type=Gnumeric_stf:stf_csv --export-file-per-sheet migel.xlsx migel_%n.csv
 //        Then pass migel_0.csv (DE), migel_1.csv (FR), migel_2.csv (IT) to parse_migel_items().
+//        migel_xlsx.hpp (zlib) reads migel.xlsx directly instead, see parse_migel_xlsx().
 #pragma once
 
 #include <string>
@@ -10,7 +11,26 @@
 #include <unordered_set>
 #include <algorithm>
 #include <fstream>
+#include <iostream>
 #include <sstream>
+#include <string_view>
+#include <span>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <bit>
+#include <cmath>
+#include <utility>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <stdexcept>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 namespace migel {
 
@@ -40,107 +60,364 @@ struct MigelItem {
     std::vector<std::string> secondary_fr;
     /// IT bonus keywords from additional lines
     std::vector<std::string> secondary_it;
-    /// Union of all keywords (used for candidate index)
-    std::vector<std::string> all_keywords;
+    /// All keywords of each language sheet, Bezeichnung and Limitation (used for the
+    /// per-language candidate index)
+    std::vector<std::string> all_keywords_de;
+    std::vector<std::string> all_keywords_fr;
+    std::vector<std::string> all_keywords_it;
+    /// Interned ids of the lists above (TokenDict), each sorted ascending
+    std::vector<uint32_t> ids_de, ids_fr, ids_it;
+    std::vector<uint32_t> secondary_ids_de, secondary_ids_fr, secondary_ids_it;
+    std::vector<uint32_t> all_ids_de, all_ids_fr, all_ids_it;
 };
 
-// ------------------------------ Stop words -----------------------------------
+// ------------------------------ Token dictionary -----------------------------
 
-inline const std::unordered_set<std::string>& stop_words() {
-    static const std::unordered_set<std::string> sw = {
-        // German articles, prepositions, conjunctions
-        "der", "die", "das", "den", "dem", "des", "ein", "eine", "eines", "einem", "einen", "einer",
-        "fuer", "mit", "von", "und", "oder", "bei", "auf", "nach", "ueber", "unter", "aus", "bis",
-        "pro", "als", "inkl", "exkl", "max", "min", "per", "zur", "zum", "ins", "vom", "ohne",
-        "auch", "sich", "noch", "wenn", "muss", "darf", "resp", "bzw",
-        // German generic terms
-        "kauf", "miete", "tag", "jahr", "monate", "stueck", "set", "alle", "nur",
-        "wird", "ist", "kann", "sind", "werden", "wurde", "hat", "haben",
-        "steril", "unsteril", "sterile", "non",
-        "diverse", "divers", "diversi",
-        "gross", "klein", "lang", "kurz",
-        "position", "definierte", "einstellbare",
-        // French
-        "les", "des", "pour", "avec", "par", "une", "dans", "sur", "qui", "que",
-        "achat", "location", "piece", "sans",
-        // Italian
-        "acquisto", "noleggio", "pezzo", "senza",
-        // English
-        "the", "for", "and", "with", "per",
-        // Generic medical/product terms
-        "material", "produkt", "products", "product", "medical", "device",
-        "system", "systeme", "systems", "geraet", "geraete", "appareil",
-        // Cross-type medical terms
-        "verlaengerung", "extension", "estensione", "prolongation",
-        "silikon", "silicone",
-        // Generic surgical instrument terms
-        "ecarteur", "divaricatore", "retraktor",
-    };
-    return sw;
+/// Dense uint32_t ids for catalog keywords, assigned by parse_migel_items().
+/// Device words that are not catalog keywords map to UNKNOWN.
+struct TokenDict {
+    static constexpr uint32_t UNKNOWN = UINT32_MAX;
+
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<std::string> tokens; // id -> keyword
+
+    uint32_t intern(const std::string& tok) {
+        auto [it, inserted] = ids.try_emplace(tok, static_cast<uint32_t>(tokens.size()));
+        if (inserted) tokens.push_back(tok);
+        return it->second;
+    }
+
+    uint32_t lookup(const std::string& tok) const {
+        auto it = ids.find(tok);
+        return it == ids.end() ? UNKNOWN : it->second;
+    }
+
+    size_t size() const { return tokens.size(); }
+};
+
+/// Intern a keyword list; returns the ids sorted ascending.
+inline std::vector<uint32_t> intern_keywords(TokenDict& dict, const std::vector<std::string>& keywords) {
+    std::vector<uint32_t> ids;
+    ids.reserve(keywords.size());
+    for (const auto& kw : keywords) ids.push_back(dict.intern(kw));
+    std::sort(ids.begin(), ids.end());
+    return ids;
 }
 
+// ------------------------------ Stop words -----------------------------------
+
+/// Keyword extraction stop words (never used as MiGeL keywords).
+inline constexpr std::string_view stop_word_list[] = {
+    // German articles, prepositions, conjunctions
+    "der", "die", "das", "den", "dem", "des", "ein", "eine", "eines", "einem", "einen", "einer",
+    "fuer", "mit", "von", "und", "oder", "bei", "auf", "nach", "ueber", "unter", "aus", "bis",
+    "pro", "als", "inkl", "exkl", "max", "min", "per", "zur", "zum", "ins", "vom", "ohne",
+    "auch", "sich", "noch", "wenn", "muss", "darf", "resp", "bzw",
+    // German generic terms
+    "kauf", "miete", "tag", "jahr", "monate", "stueck", "set", "alle", "nur",
+    "wird", "ist", "kann", "sind", "werden", "wurde", "hat", "haben",
+    "steril", "unsteril", "sterile", "non",
+    "diverse", "divers", "diversi",
+    "gross", "klein", "lang", "kurz",
+    "position", "definierte", "einstellbare",
+    // French
+    "les", "des", "pour", "avec", "par", "une", "dans", "sur", "qui", "que",
+    "achat", "location", "piece", "sans",
+    // Italian
+    "acquisto", "noleggio", "pezzo", "senza",
+    // English
+    "the", "for", "and", "with", "per",
+    // Generic medical/product terms
+    "material", "produkt", "products", "product", "medical", "device",
+    "system", "systeme", "systems", "geraet", "geraete", "appareil",
+    // Cross-type medical terms
+    "verlaengerung", "extension", "estensione", "prolongation",
+    "silikon", "silicone",
+    // Generic surgical instrument terms
+    "ecarteur", "divaricatore", "retraktor",
+};
+
 // ------------------------------ Language detection stop words -----------------
 
-inline const std::unordered_set<std::string>& lang_stop_de() {
-    static const std::unordered_set<std::string> s = {
-        "der", "die", "das", "den", "dem", "des",
-        "ein", "eine", "eines", "einem", "einen", "einer",
-        "und", "oder", "fuer", "mit", "von", "bei",
-        "auf", "nach", "ueber", "unter", "aus", "bis",
-        "zur", "zum", "ins", "vom", "ohne", "auch",
-        "sich", "noch", "wenn", "wird", "ist", "kann",
-        "sind", "werden", "wurde", "hat", "haben",
-        "nicht", "nur", "aber", "wie", "dieser", "diese",
-        "dieses", "welche", "zwischen", "durch",
-    };
-    return s;
+inline constexpr std::string_view lang_stop_de_list[] = {
+    "der", "die", "das", "den", "dem", "des",
+    "ein", "eine", "eines", "einem", "einen", "einer",
+    "und", "oder", "fuer", "mit", "von", "bei",
+    "auf", "nach", "ueber", "unter", "aus", "bis",
+    "zur", "zum", "ins", "vom", "ohne", "auch",
+    "sich", "noch", "wenn", "wird", "ist", "kann",
+    "sind", "werden", "wurde", "hat", "haben",
+    "nicht", "nur", "aber", "wie", "dieser", "diese",
+    "dieses", "welche", "zwischen", "durch",
+};
+
+inline constexpr std::string_view lang_stop_fr_list[] = {
+    "le", "la", "les", "des", "du",
+    "et", "en", "un", "une", "pour", "avec",
+    "dans", "sur", "qui", "que", "est", "sont",
+    "pas", "par", "aux", "ou", "ce", "cette",
+    "ces", "mais", "plus", "tout", "tous",
+    "peut", "entre", "aussi", "comme", "sans",
+};
+
+inline constexpr std::string_view lang_stop_it_list[] = {
+    "il", "lo", "gli", "di",
+    "del", "della", "dei", "delle", "dello",
+    "ed", "uno", "per", "con",
+    "che", "sono", "nel", "nella", "nei", "nelle",
+    "sul", "sulla", "sui", "sulle",
+    "questo", "questa", "questi", "queste",
+    "non", "dal", "dalla", "dai", "dalle",
+};
+
+inline constexpr std::string_view lang_stop_en_list[] = {
+    "the", "and", "for", "with", "is", "are",
+    "has", "have", "this", "that", "from", "was",
+    "were", "been", "being", "which", "their",
+    "into", "than", "its", "can", "may",
+    "used", "intended", "designed", "device",
+    "shall", "should", "will", "must", "not",
+};
+
+// ------------------------------ Stop-word table -------------------------------
+// All five lists are merged at compile time into one perfect-hash table keyed on
+// std::string_view. A lookup is one hash plus one probe and returns a bitmask of the
+// lists that contain the word.
+
+/// Bit flags for stop_lists().
+enum StopList : uint8_t { STOP_KEYWORD = 1, STOP_DE = 2, STOP_FR = 4, STOP_IT = 8, STOP_EN = 16 };
+
+namespace stop_table {
+
+constexpr size_t SLOTS = 1024;  // power of two
+constexpr size_t BUCKETS = 128; // power of two
+
+struct Entry {
+    std::string_view word;
+    uint8_t lists = 0;
+};
+
+struct Table {
+    uint64_t seed = 0;
+    std::array<uint16_t, BUCKETS> displace{};
+    std::array<Entry, SLOTS> slots{};
+};
+
+/// FNV-1a with a final avalanche (murmur3 fmix64).
+constexpr uint64_t hash(std::string_view s, uint64_t seed) {
+    uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+    for (char c : s) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
 }
 
-inline const std::unordered_set<std::string>& lang_stop_fr() {
-    static const std::unordered_set<std::string> s = {
-        "le", "la", "les", "des", "du",
-        "et", "en", "un", "une", "pour", "avec",
-        "dans", "sur", "qui", "que", "est", "sont",
-        "pas", "par", "aux", "ou", "ce", "cette",
-        "ces", "mais", "plus", "tout", "tous",
-        "peut", "entre", "aussi", "comme", "sans",
-    };
-    return s;
-}
-
-inline const std::unordered_set<std::string>& lang_stop_it() {
-    static const std::unordered_set<std::string> s = {
-        "il", "lo", "gli", "di",
-        "del", "della", "dei", "delle", "dello",
-        "ed", "uno", "per", "con",
-        "che", "sono", "nel", "nella", "nei", "nelle",
-        "sul", "sulla", "sui", "sulle",
-        "questo", "questa", "questi", "queste",
-        "non", "dal", "dalla", "dai", "dalle",
-    };
-    return s;
+// High bits pick the bucket, low bits the base slot; slot = base ^ displace[bucket].
+constexpr size_t bucket_of(uint64_t h) { return static_cast<size_t>(h >> 57) & (BUCKETS - 1); }
+constexpr size_t base_of(uint64_t h) { return static_cast<size_t>(h) & (SLOTS - 1); }
+
+constexpr size_t word_count() {
+    return std::size(stop_word_list) + std::size(lang_stop_de_list) + std::size(lang_stop_fr_list) +
+           std::size(lang_stop_it_list) + std::size(lang_stop_en_list);
 }
 
-inline const std::unordered_set<std::string>& lang_stop_en() {
-    static const std::unordered_set<std::string> s = {
-        "the", "and", "for", "with", "is", "are",
-        "has", "have", "this", "that", "from", "was",
-        "were", "been", "being", "which", "their",
-        "into", "than", "its", "can", "may",
-        "used", "intended", "designed", "device",
-        "shall", "should", "will", "must", "not",
+/// Hash-and-displace construction: buckets are placed largest first, each with the
+/// first displacement whose slots are all free. A new seed is tried if two words of
+/// one bucket share a base slot or a bucket cannot be placed.
+constexpr Table build() {
+    std::array<Entry, word_count()> words{};
+    size_t n = 0;
+    auto add = [&](std::string_view w, uint8_t list) {
+        for (size_t i = 0; i < n; ++i)
+            if (words[i].word == w) { words[i].lists |= list; return; }
+        words[n++] = {w, list};
     };
-    return s;
+    for (auto w : stop_word_list) add(w, STOP_KEYWORD);
+    for (auto w : lang_stop_de_list) add(w, STOP_DE);
+    for (auto w : lang_stop_fr_list) add(w, STOP_FR);
+    for (auto w : lang_stop_it_list) add(w, STOP_IT);
+    for (auto w : lang_stop_en_list) add(w, STOP_EN);
+
+    for (uint64_t seed = 0;; ++seed) {
+        Table t;
+        t.seed = seed;
+        std::array<size_t, BUCKETS> bucket_size{};
+        for (size_t i = 0; i < n; ++i) ++bucket_size[bucket_of(hash(words[i].word, seed))];
+
+        bool ok = true;
+        std::array<bool, SLOTS> used{};
+        for (size_t size = n; size > 0 && ok; --size) {
+            for (size_t b = 0; b < BUCKETS && ok; ++b) {
+                if (bucket_size[b] != size) continue;
+                ok = false;
+                for (size_t d = 0; d < SLOTS && !ok; ++d) {
+                    std::array<bool, SLOTS> taken = used;
+                    bool fits = true;
+                    for (size_t i = 0; i < n && fits; ++i) {
+                        uint64_t h = hash(words[i].word, seed);
+                        if (bucket_of(h) != b) continue;
+                        size_t slot = base_of(h) ^ d;
+                        if (taken[slot]) fits = false;
+                        else taken[slot] = true;
+                    }
+                    if (!fits) continue;
+                    used = taken;
+                    t.displace[b] = static_cast<uint16_t>(d);
+                    ok = true;
+                }
+            }
+        }
+        if (!ok) continue;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t h = hash(words[i].word, seed);
+            t.slots[base_of(h) ^ t.displace[bucket_of(h)]] = words[i];
+        }
+        return t;
+    }
+}
+
+inline constexpr Table table = build();
+
+} // namespace stop_table
+
+/// Stop-word lists (StopList bits) that contain word; 0 if none.
+constexpr uint8_t stop_lists(std::string_view word) {
+    uint64_t h = stop_table::hash(word, stop_table::table.seed);
+    const auto& e = stop_table::table.slots[stop_table::base_of(h) ^
+                                             stop_table::table.displace[stop_table::bucket_of(h)]];
+    return e.word == word ? e.lists : 0;
+}
+
+/// Every listed word is found with its list bit.
+constexpr bool stop_lists_complete() {
+    for (auto w : stop_word_list) if (!(stop_lists(w) & STOP_KEYWORD)) return false;
+    for (auto w : lang_stop_de_list) if (!(stop_lists(w) & STOP_DE)) return false;
+    for (auto w : lang_stop_fr_list) if (!(stop_lists(w) & STOP_FR)) return false;
+    for (auto w : lang_stop_it_list) if (!(stop_lists(w) & STOP_IT)) return false;
+    for (auto w : lang_stop_en_list) if (!(stop_lists(w) & STOP_EN)) return false;
+    return true;
+}
+
+static_assert(stop_lists_complete());
+static_assert(stop_lists("der") == (STOP_KEYWORD | STOP_DE));
+static_assert(stop_lists("des") == (STOP_KEYWORD | STOP_DE | STOP_FR));
+static_assert(stop_lists("per") == (STOP_KEYWORD | STOP_IT));
+static_assert(stop_lists("device") == (STOP_KEYWORD | STOP_EN));
+static_assert(stop_lists("katheter") == 0 && stop_lists("") == 0);
+
+// ------------------------------ SIMD text kernels -----------------------------
+// Most trade names are pure ASCII. These kernels find the length of an ASCII run and
+// lower-case ASCII in 16/32-byte blocks; callers only fall back to the per-byte UTF-8
+// path at multi-byte sequences. The implementation (AVX2, SSE2 or scalar) is chosen
+// once at runtime; all variants give identical results.
+
+namespace simd {
+
+inline size_t ascii_run_scalar(const char* p, size_t n) {
+    size_t i = 0;
+    while (i < n && static_cast<unsigned char>(p[i]) < 0x80) ++i;
+    return i;
+}
+
+/// Same mapping as std::tolower in the "C" locale: only 'A'..'Z' change.
+inline void lower_ascii_scalar(const char* src, char* dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        char c = src[i];
+        dst[i] = (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MIGEL_SIMD_X86 1
+
+inline size_t ascii_run_sse2(const char* p, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        int m = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)));
+        if (m) return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(m)));
+    }
+    return i + ascii_run_scalar(p + i, n - i);
+}
+
+inline void lower_ascii_sse2(const char* src, char* dst, size_t n) {
+    const __m128i before_a = _mm_set1_epi8('A' - 1), after_z = _mm_set1_epi8('Z' + 1);
+    const __m128i delta = _mm_set1_epi8('a' - 'A');
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, before_a), _mm_cmplt_epi8(v, after_z));
+        v = _mm_add_epi8(v, _mm_and_si128(upper, delta));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+    }
+    lower_ascii_scalar(src + i, dst + i, n - i);
 }
 
+__attribute__((target("avx2")))
+inline size_t ascii_run_avx2(const char* p, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        int m = _mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)));
+        if (m) return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(m)));
+    }
+    return i + ascii_run_sse2(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+inline void lower_ascii_avx2(const char* src, char* dst, size_t n) {
+    const __m256i before_a = _mm256_set1_epi8('A' - 1), after_z = _mm256_set1_epi8('Z' + 1);
+    const __m256i delta = _mm256_set1_epi8('a' - 'A');
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, before_a), _mm256_cmpgt_epi8(after_z, v));
+        v = _mm256_add_epi8(v, _mm256_and_si256(upper, delta));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+    }
+    lower_ascii_sse2(src + i, dst + i, n - i);
+}
+#endif
+
+struct TextKernels {
+    const char* name;
+    size_t (*ascii_run)(const char* p, size_t n);               // leading bytes < 0x80
+    void (*lower_ascii)(const char* src, char* dst, size_t n);  // 'A'..'Z' -> 'a'..'z'
+};
+
+/// Kernels for the running CPU, selected on first use.
+inline const TextKernels& kernels() {
+    static const TextKernels k = [] {
+#ifdef MIGEL_SIMD_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return TextKernels{"avx2", ascii_run_avx2, lower_ascii_avx2};
+        return TextKernels{"sse2", ascii_run_sse2, lower_ascii_sse2};
+#else
+        return TextKernels{"scalar", ascii_run_scalar, lower_ascii_scalar};
+#endif
+    }();
+    return k;
+}
+
+} // namespace simd
+
 // ------------------------------ Text utilities --------------------------------
 
 /// Normalize German umlauts so ALL-CAPS text matches proper text.
 inline std::string normalize_german(const std::string& text) {
     std::string out;
     out.reserve(text.size() + 32);
+    const auto& k = simd::kernels();
     size_t i = 0;
     while (i < text.size()) {
+        size_t run = k.ascii_run(text.data() + i, text.size() - i);
+        out.append(text, i, run);
+        i += run;
+        if (i == text.size()) break;
         unsigned char c = static_cast<unsigned char>(text[i]);
         // UTF-8 two-byte sequences starting with 0xC3
         if (c == 0xC3 && i + 1 < text.size()) {
@@ -173,9 +450,8 @@ inline std::string normalize_german(const std::string& text) {
 }
 
 inline std::string to_lower(const std::string& s) {
-    std::string out = s;
-    std::transform(out.begin(), out.end(), out.begin(),
-                   [](unsigned char c) { return std::tolower(c); });
+    std::string out(s.size(), '\0');
+    simd::kernels().lower_ascii(s.data(), out.data(), s.size());
     return out;
 }
 
@@ -220,6 +496,164 @@ inline std::vector<std::string> split_words(const std::string& text) {
     return words;
 }
 
+/// Lower-case ASCII folding of a German/French UTF-8 letter (0xC3 xx), as produced by
+/// to_lower(normalize_german(...)); nullptr if normalize_german keeps the bytes.
+inline const char* fold_c3(unsigned char c2) {
+    switch (c2) {
+        case 0xA4: case 0x84: return "ae"; // ä Ä
+        case 0xB6: case 0x96: return "oe"; // ö Ö
+        case 0xBC: case 0x9C: return "ue"; // ü Ü
+        case 0x9F: return "ss";            // ß
+        case 0xA9: case 0xA8: case 0xAA: return "e"; // é è ê
+        case 0xA0: case 0xA2: return "a";  // à â
+        case 0xB9: case 0xBB: return "u";  // ù û
+        case 0xB4: return "o";             // ô
+        case 0xAE: return "i";             // î
+        case 0xA7: return "c";             // ç
+        default: return nullptr;
+    }
+}
+
+/// Normalized, lower-cased text and its words; reused across calls so the matching
+/// loop does not allocate once the buffers have grown. Memory comes from mr (the heap
+/// by default, or a ScratchArena).
+struct NormalizedText {
+    std::pmr::string text;                    // to_lower(normalize_german(...)) output
+    std::pmr::vector<std::string_view> words; // split_words(text), views into text
+
+    explicit NormalizedText(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+        : text(mr), words(mr) {}
+
+    void clear() {
+        text.clear();
+        words.clear();
+    }
+};
+
+/// Fused normalize_german + to_lower + split_words in a single pass: appends the
+/// normalized form of in to out.text and its words to out.words (words never span
+/// two calls). Existing views are re-based if out.text has to grow.
+inline void normalize_append(std::string_view in, NormalizedText& out) {
+    auto& text = out.text;
+    size_t need = text.size() + in.size(); // output is never longer than input
+    if (need > text.capacity()) {
+        const char* old = text.data();
+        text.reserve(std::max(need, 2 * text.capacity()));
+        for (auto& w : out.words) w = {text.data() + (w.data() - old), w.size()};
+    }
+
+    size_t word_start = std::string::npos;
+    auto is_alnum = [](char ch) { return (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9'); };
+    auto put = [&](char ch) {
+        bool alnum = is_alnum(ch);
+        if (alnum && word_start == std::string::npos) {
+            word_start = text.size();
+        } else if (!alnum && word_start != std::string::npos) {
+            out.words.emplace_back(text.data() + word_start, text.size() - word_start);
+            word_start = std::string::npos;
+        }
+        text.push_back(ch);
+    };
+
+    const auto& k = simd::kernels();
+    size_t i = 0;
+    while (i < in.size()) {
+        // Pure-ASCII run: lower-case in bulk, then find word boundaries in the output
+        size_t run = k.ascii_run(in.data() + i, in.size() - i);
+        if (run) {
+            size_t base = text.size();
+            text.resize(base + run);
+            char* dst = text.data() + base;
+            k.lower_ascii(in.data() + i, dst, run);
+            for (size_t j = 0; j < run; ++j) {
+                bool alnum = is_alnum(dst[j]);
+                if (alnum && word_start == std::string::npos) {
+                    word_start = base + j;
+                } else if (!alnum && word_start != std::string::npos) {
+                    out.words.emplace_back(text.data() + word_start, base + j - word_start);
+                    word_start = std::string::npos;
+                }
+            }
+            i += run;
+            if (i == in.size()) break;
+        }
+        unsigned char c = static_cast<unsigned char>(in[i]);
+        if (c == 0xC3 && i + 1 < in.size()) {
+            if (const char* f = fold_c3(static_cast<unsigned char>(in[i + 1]))) {
+                for (; *f; ++f) put(*f);
+                i += 2;
+                continue;
+            }
+        }
+        put(static_cast<char>(c)); // non-ASCII byte: never a word character
+        ++i;
+    }
+    if (word_start != std::string::npos)
+        out.words.emplace_back(text.data() + word_start, text.size() - word_start);
+}
+
+// ------------------------------ Light stemming --------------------------------
+
+/// Light plural/case stemmers for normalized, lower-cased words (normalize_append()
+/// output). Each strips at most one inflectional ending and never shortens a word
+/// below 4 chars; they conflate singular/plural forms, nothing more.
+
+inline bool ends_with(std::string_view w, std::string_view end) {
+    return w.size() >= end.size() && w.compare(w.size() - end.size(), end.size(), end) == 0;
+}
+
+/// German: -ern, then -em/-en/-er/-es, then -e/-n/-s (umlauts are already folded).
+inline std::string_view stem_de(std::string_view w) {
+    size_t n = w.size();
+    if (n > 6 && ends_with(w, "ern")) return w.substr(0, n - 3);
+    if (n > 5 && (ends_with(w, "em") || ends_with(w, "en") || ends_with(w, "er") || ends_with(w, "es")))
+        return w.substr(0, n - 2);
+    if (n > 4 && (w.back() == 'e' || w.back() == 'n' || w.back() == 's')) return w.substr(0, n - 1);
+    return w;
+}
+
+/// French: plural -s/-x, then feminine -e. A past participle folded from -ée(s)
+/// loses both e when at least 5 chars remain (stérilisées -> sterilisees -> sterilis,
+/// like stérilisé); shorter ones keep one (entrée -> entre, apart from entre -> entr).
+/// "-aux" plurals (canaux) are stemmed by stem_append(), which needs to write "-al".
+inline std::string_view stem_fr(std::string_view w) {
+    bool participle = ends_with(w, "ee") || ends_with(w, "ees");
+    if (w.size() > 4 && (w.back() == 's' || w.back() == 'x')) w.remove_suffix(1);
+    if (w.size() > 4 && w.back() == 'e') {
+        w.remove_suffix(1);
+        if (participle && w.size() > 5) w.remove_suffix(1);
+    }
+    return w;
+}
+
+/// Italian: final vowel, keeping the hard c/g of -chi/-che/-ghi/-ghe plurals.
+inline std::string_view stem_it(std::string_view w) {
+    size_t n = w.size();
+    if (n > 5 && (ends_with(w, "chi") || ends_with(w, "che") || ends_with(w, "ghi") || ends_with(w, "ghe")))
+        return w.substr(0, n - 2);
+    if (n > 4 && (w.back() == 'a' || w.back() == 'e' || w.back() == 'i' || w.back() == 'o'))
+        return w.substr(0, n - 1);
+    return w;
+}
+
+/// Append the stem of w in language lang (DE, FR or IT) to out.
+template <class Str>
+inline void stem_append(Lang lang, std::string_view w, Str& out) {
+    switch (lang) {
+        case Lang::DE: out.append(stem_de(w)); break;
+        case Lang::FR:
+            if (w.size() > 5 && ends_with(w, "aux")) {
+                out.append(w.substr(0, w.size() - 3));
+                out.append("al");
+            } else {
+                out.append(stem_fr(w));
+            }
+            break;
+        case Lang::IT: out.append(stem_it(w)); break;
+        default: out.append(w); break;
+    }
+}
+
 // ------------------------------ Language detection ----------------------------
 
 /// Detect the dominant language of a text string (EN, DE, FR, IT).
@@ -227,11 +661,15 @@ inline std::vector<std::string> split_words(const std::string& text) {
 /// Returns UNKNOWN only when foreign characters are detected (non-DE/FR/IT accents,
 /// non-Latin scripts). Short/ambiguous text with no indicators returns EN (safe default).
 /// Must be called on raw UTF-8 text (before normalize_german).
-inline LangDetectResult detect_language(const std::string& text) {
+/// scratch: reusable buffer for the normalized words.
+inline LangDetectResult detect_language(const std::string& text, NormalizedText& scratch) {
     // Step 1: Count character features on raw UTF-8 bytes
     int char_de = 0, char_fr = 0, char_it = 0;
     int char_foreign = 0; // accents/chars outside DE/FR/IT
+    const auto& k = simd::kernels();
     for (size_t i = 0; i < text.size(); ++i) {
+        i += k.ascii_run(text.data() + i, text.size() - i); // ASCII bytes carry no features
+        if (i == text.size()) break;
         unsigned char c = static_cast<unsigned char>(text[i]);
         if (c == 0xC3 && i + 1 < text.size()) {
             unsigned char c2 = static_cast<unsigned char>(text[i + 1]);
@@ -281,20 +719,18 @@ inline LangDetectResult detect_language(const std::string& text) {
     }
 
     // Step 2: Count stop-word hits (on normalized+lowered text)
-    std::string lower = to_lower(normalize_german(text));
-    auto words = split_words(lower);
+    scratch.clear();
+    normalize_append(text, scratch);
 
     int stop_de = 0, stop_fr = 0, stop_it = 0, stop_en = 0;
-    const auto& de_sw = lang_stop_de();
-    const auto& fr_sw = lang_stop_fr();
-    const auto& it_sw = lang_stop_it();
-    const auto& en_sw = lang_stop_en();
 
-    for (const auto& w : words) {
-        if (de_sw.count(w)) stop_de++;
-        if (fr_sw.count(w)) stop_fr++;
-        if (it_sw.count(w)) stop_it++;
-        if (en_sw.count(w)) stop_en++;
+    for (std::string_view w : scratch.words) {
+        uint8_t lists = stop_lists(w);
+        if (!lists) continue;
+        if (lists & STOP_DE) stop_de++;
+        if (lists & STOP_FR) stop_fr++;
+        if (lists & STOP_IT) stop_it++;
+        if (lists & STOP_EN) stop_en++;
     }
 
     // Step 3: Combine (character features weighted 2x — stronger signal)
@@ -323,15 +759,173 @@ inline LangDetectResult detect_language(const std::string& text) {
     return {scores[0].lang, scores[0].score, scores[0].score - scores[1].score};
 }
 
+inline LangDetectResult detect_language(const std::string& text) {
+    thread_local NormalizedText scratch;
+    return detect_language(text, scratch);
+}
+
+// ------------------------------ Language detection cache ----------------------
+
+/// 64-bit hash of a field text (8 bytes per step). Stable across runs on one host,
+/// so it can key a persisted LangCache.
+inline uint64_t text_hash(std::string_view s) {
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ s.size();
+    size_t i = 0;
+    for (; i + 8 <= s.size(); i += 8) {
+        uint64_t w;
+        std::memcpy(&w, s.data() + i, 8);
+        h = (h ^ w) * 0xff51afd7ed558ccdULL;
+        h ^= h >> 32;
+    }
+    uint64_t w = 0;
+    std::memcpy(&w, s.data() + i, s.size() - i);
+    h = (h ^ w) * 0xc4ceb9fe1a85ec53ULL;
+    return h ^ (h >> 29);
+}
+
+/// detect_language() results keyed by text_hash() of the field, shared by all threads
+/// (64 mutex-guarded shards). EUDAMED repeats the same CND descriptions and trade
+/// names across many devices; a hit skips the byte scan and stop-word counting. Two
+/// texts with equal 64-bit hashes would share a result. Entries can be saved to and
+/// loaded from a side file (host byte order, like the catalog snapshot).
+class LangCache {
+public:
+    /// Bump when detect_language() changes, so older side files are ignored.
+    static constexpr uint32_t VERSION = 3;
+
+    LangDetectResult detect(const std::string& text, NormalizedText& scratch) {
+        uint64_t key = text_hash(text);
+        Shard& shard = shards_[key % SHARDS];
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.map.find(key);
+            if (it != shard.map.end()) {
+                ++shard.hits;
+                return it->second;
+            }
+            ++shard.misses;
+        }
+        LangDetectResult r = detect_language(text, scratch);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.map.emplace(key, r);
+        return r;
+    }
+
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t entries = 0;
+    };
+
+    Stats stats() const {
+        Stats st;
+        for (const Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            st.hits += shard.hits;
+            st.misses += shard.misses;
+            st.entries += shard.map.size();
+        }
+        return st;
+    }
+
+    /// Add the entries of a side file written by save(). Returns the number of
+    /// entries read; 0 if the file is missing, malformed or from another VERSION.
+    size_t load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        auto bytes = static_cast<uint64_t>(std::max<std::streamoff>(in.tellg(), 0));
+        in.seekg(0);
+        FileHeader h{};
+        if (!in.read(reinterpret_cast<char*>(&h), sizeof(h)) ||
+            std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.version != VERSION ||
+            h.count != (bytes - sizeof(h)) / sizeof(Record))
+            return 0;
+        std::vector<Record> records(h.count);
+        if (!in.read(reinterpret_cast<char*>(records.data()),
+                     static_cast<std::streamsize>(records.size() * sizeof(Record))))
+            return 0;
+        if (std::any_of(records.begin(), records.end(),
+                        [](const Record& r) { return r.lang > static_cast<uint32_t>(Lang::UNKNOWN); }))
+            return 0;
+        for (const Record& r : records) {
+            Shard& shard = shards_[r.key % SHARDS];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.map.emplace(r.key, LangDetectResult{static_cast<Lang>(r.lang), r.score, r.confidence});
+        }
+        return records.size();
+    }
+
+    /// Write all entries to path (via a temporary file renamed into place). Returns
+    /// false on I/O errors.
+    bool save(const std::string& path) const {
+        std::vector<Record> records;
+        for (const Shard& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (const auto& [key, r] : shard.map)
+                records.push_back({key, r.score, r.confidence, static_cast<uint32_t>(r.lang), 0});
+        }
+        FileHeader h{};
+        std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+        h.version = VERSION;
+        h.count = records.size();
+        // Random temporary name next to path, so concurrent runs never share one
+        std::random_device rd;
+        char suffix[24];
+        std::snprintf(suffix, sizeof(suffix), ".tmp%08x%08x", rd(), rd());
+        std::string tmp = path + suffix;
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+            out.write(reinterpret_cast<const char*>(records.data()),
+                      static_cast<std::streamsize>(records.size() * sizeof(Record)));
+            if (!out.flush()) {
+                std::remove(tmp.c_str());
+                return false;
+            }
+        }
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+            std::remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t SHARDS = 64;
+    static constexpr char MAGIC[8] = {'M', 'I', 'G', 'E', 'L', 'L', 'N', 'G'};
+
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<uint64_t, LangDetectResult> map;
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t count;
+    };
+
+    struct Record {
+        uint64_t key;
+        int32_t score;
+        int32_t confidence;
+        uint32_t lang;
+        uint32_t reserved;
+    };
+
+    std::array<Shard, SHARDS> shards_;
+};
+
 /// Shared keyword extraction logic.
 inline std::vector<std::string> extract_keywords_from(const std::string& text, size_t min_len) {
     std::string normalized = to_lower(normalize_german(text));
     auto words = split_words(normalized);
-    const auto& sw = stop_words();
 
     std::vector<std::string> keywords;
     for (auto& w : words) {
-        if (w.size() >= min_len && sw.find(w) == sw.end()) {
+        if (w.size() >= min_len && !(stop_lists(w) & STOP_KEYWORD)) {
             keywords.push_back(std::move(w));
         }
     }
@@ -359,49 +953,58 @@ inline std::vector<std::string> extract_secondary_keywords(const std::string& te
 
 // ------------------------------ RFC 4180 CSV parser ---------------------------
 
-/// Parse a single CSV row from a stream, handling quoted fields with embedded
-/// newlines and escaped quotes. Returns false on EOF.
-inline bool parse_csv_row(std::istream& in, std::vector<std::string>& fields) {
-    fields.clear();
-    std::string field;
-    bool in_quotes = false;
-    char c;
-
-    while (in.get(c)) {
-        if (in_quotes) {
-            if (c == '"') {
-                char next = static_cast<char>(in.peek());
-                if (next == '"') {
-                    in.get(c); // consume escaped quote
-                    field += '"';
-                } else {
-                    in_quotes = false;
-                }
-            } else {
-                field += c;
+/// Read a whole file into out with one read. Returns false if it cannot be opened.
+inline bool read_file(const std::string& path, std::string& out) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) return false;
+    out.resize(static_cast<size_t>(std::max<std::streamoff>(in.tellg(), 0)));
+    in.seekg(0);
+    in.read(out.data(), static_cast<std::streamsize>(out.size()));
+    out.resize(static_cast<size_t>(in.gcount()));
+    return true;
+}
+
+/// Parse the CSV row starting at data[pos], handling quoted fields with embedded
+/// newlines and escaped quotes, and advance pos past it. Unquoted runs and quoted runs
+/// are copied in one piece. Returns false at the end of data.
+inline bool parse_csv_row(std::string_view data, size_t& pos, std::vector<std::string>& fields) {
+    size_t n = 0;
+    auto next_field = [&]() -> std::string& {
+        if (n == fields.size()) fields.emplace_back();
+        fields[n].clear();
+        return fields[n++];
+    };
+    std::string* field = &next_field();
+    while (pos < data.size()) {
+        char c = data[pos];
+        if (c == '"') {
+            ++pos;
+            while (pos < data.size()) {
+                size_t quote = std::min(data.find('"', pos), data.size());
+                field->append(data.substr(pos, quote - pos));
+                pos = quote + 1;
+                if (pos >= data.size() || data[pos] != '"') break;
+                *field += '"'; // escaped quote
+                ++pos;
             }
+        } else if (c == ',') {
+            ++pos;
+            field = &next_field();
+        } else if (c == '\n') {
+            ++pos;
+            fields.resize(n);
+            return true;
+        } else if (c == '\r') {
+            ++pos; // skip \r, \n will follow
         } else {
-            if (c == '"') {
-                in_quotes = true;
-            } else if (c == ',') {
-                fields.push_back(field);
-                field.clear();
-            } else if (c == '\n') {
-                fields.push_back(field);
-                return true;
-            } else if (c == '\r') {
-                // skip \r, \n will follow
-            } else {
-                field += c;
-            }
+            size_t end = std::min(data.find_first_of(",\"\r\n", pos), data.size());
+            field->append(data.substr(pos, end - pos));
+            pos = end;
         }
     }
-    // EOF
-    if (!field.empty() || !fields.empty()) {
-        fields.push_back(field);
-        return true;
-    }
-    return false;
+    // End of data
+    fields.resize(n);
+    return n > 1 || !fields[0].empty();
 }
 
 /// Get a field by index, returning empty string if out of bounds.
@@ -410,26 +1013,55 @@ inline std::string csv_field(const std::vector<std::string>& fields, size_t idx)
     return trim(fields[idx]);
 }
 
+// ------------------------------ Parallel build --------------------------------
+
+/// Call f(begin, end) on one contiguous chunk of [0, n) per hardware thread and wait
+/// for all of them. Runs inline on one core or when chunks would be under min_chunk.
+template <class F>
+inline void parallel_for(size_t n, F&& f, size_t min_chunk = 64) {
+    size_t threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                      (n + min_chunk - 1) / min_chunk);
+    if (threads <= 1) {
+        f(size_t{0}, n);
+        return;
+    }
+    std::vector<std::thread> pool;
+    size_t chunk = n / threads;
+    size_t remainder = n % threads;
+    size_t offset = 0;
+    for (size_t t = 0; t < threads; ++t) {
+        size_t start = offset;
+        size_t end = offset + chunk + (t < remainder ? 1 : 0);
+        offset = end;
+        if (t + 1 < threads) pool.emplace_back([&f, start, end] { f(start, end); });
+        else f(start, end);
+    }
+    for (auto& t : pool) t.join();
+}
+
 // ------------------------------ CSV parsing -----------------------------------
 
-/// Parse a single MiGeL CSV sheet. Returns rows as (pos_nr, bezeichnung, limitation).
+/// Rows of one MiGeL sheet as (pos_nr, bezeichnung, limitation), header row skipped.
+using SheetRows = std::vector<std::tuple<std::string, std::string, std::string>>;
+
+/// Parse a single MiGeL CSV sheet.
 /// Column indices: 7=Positions-Nr (H), 9=Bezeichnung (J), 10=Limitation (K)
 /// Category rows (1..6, cols B-G) have no Positions-Nr.
-inline std::vector<std::tuple<std::string, std::string, std::string>>
-parse_csv_sheet(const std::string& path) {
-    std::ifstream file(path);
-    if (!file.is_open()) {
+inline SheetRows parse_csv_sheet(const std::string& path) {
+    std::string data;
+    if (!read_file(path, data)) {
         std::cerr << "Error: cannot open " << path << "\n";
         return {};
     }
 
-    std::vector<std::tuple<std::string, std::string, std::string>> rows;
+    SheetRows rows;
     std::vector<std::string> fields;
+    size_t pos = 0;
 
     // Skip header row
-    parse_csv_row(file, fields);
+    parse_csv_row(data, pos, fields);
 
-    while (parse_csv_row(file, fields)) {
+    while (parse_csv_row(data, pos, fields)) {
         std::string pos_nr = csv_field(fields, 7);
         std::string bezeichnung = csv_field(fields, 9);
         std::string limitation = csv_field(fields, 10);
@@ -438,115 +1070,936 @@ parse_csv_sheet(const std::string& path) {
     return rows;
 }
 
-/// Parse MiGeL items from CSV files (one per language sheet).
+/// Keywords of one sheet row: first-line and secondary keywords of the Bezeichnung, and
+/// all keywords of Bezeichnung and Limitation (sorted, deduplicated).
+struct RowKeywords {
+    std::vector<std::string> keywords;
+    std::vector<std::string> secondary;
+    std::vector<std::string> all;
+};
+
+inline RowKeywords extract_row_keywords(const std::string& bezeichnung, const std::string& limitation) {
+    RowKeywords row;
+    row.keywords = extract_keywords(bezeichnung);
+    row.secondary = extract_secondary_keywords(bezeichnung);
+    row.all = extract_keywords_full(bezeichnung);
+    if (!limitation.empty()) {
+        auto lim_kw = extract_keywords_full(limitation);
+        row.all.insert(row.all.end(), lim_kw.begin(), lim_kw.end());
+        std::sort(row.all.begin(), row.all.end());
+        row.all.erase(std::unique(row.all.begin(), row.all.end()), row.all.end());
+    }
+    return row;
+}
+
+/// Build MiGeL items from the parsed DE, FR and IT sheets (FR and IT may be empty).
+/// tokens: receives the ids of all catalog keywords (MigelItem::ids_* refer to it)
+///
+/// Keywords are extracted in parallel per row; the result (items and token ids) is the
+/// same as a sequential build.
+inline std::vector<MigelItem> build_migel_items(TokenDict& tokens, const std::array<SheetRows, 3>& sheets) {
+    // --- Pass 1: One item per DE row; FR and IT rows join by Positions-Nr ---
+    struct RowTask {
+        uint32_t lang;
+        uint32_t row;
+        uint32_t item;
+    };
+    std::vector<MigelItem> items;
+    std::vector<RowTask> tasks;
+    std::unordered_map<std::string, size_t> pos_map;
+    for (size_t r = 0; r < sheets[0].size(); ++r) {
+        const auto& [pos_nr, bezeichnung, limitation] = sheets[0][r];
+        if (pos_nr.empty()) continue; // category header row
+        MigelItem item;
+        item.position_nr = pos_nr;
+        item.bezeichnung = first_line(bezeichnung);
+        item.limitation = limitation;
+        pos_map[pos_nr] = items.size();
+        tasks.push_back({0, static_cast<uint32_t>(r), static_cast<uint32_t>(items.size())});
+        items.push_back(std::move(item));
+    }
+    for (uint32_t l = 1; l < 3; ++l) {
+        for (size_t r = 0; r < sheets[l].size(); ++r) {
+            const std::string& pos_nr = std::get<0>(sheets[l][r]);
+            if (pos_nr.empty()) continue;
+            auto it = pos_map.find(pos_nr);
+            if (it == pos_map.end()) continue;
+            tasks.push_back({l, static_cast<uint32_t>(r), static_cast<uint32_t>(it->second)});
+        }
+    }
+
+    // --- Pass 2: Extract keywords of all rows in parallel ---
+    std::vector<RowKeywords> extracted(tasks.size());
+    parallel_for(tasks.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const auto& [pos_nr, bezeichnung, limitation] = sheets[tasks[i].lang][tasks[i].row];
+            extracted[i] = extract_row_keywords(bezeichnung, limitation);
+        }
+    });
+
+    // Merge in sheet order: a Positions-Nr repeated in the FR or IT sheet keeps the
+    // first-line and secondary keywords of its last row and the union of all keywords
+    // of its rows
+    using List = std::vector<std::string> MigelItem::*;
+    const List keywords[3] = {&MigelItem::keywords_de, &MigelItem::keywords_fr, &MigelItem::keywords_it};
+    const List secondary[3] = {&MigelItem::secondary_de, &MigelItem::secondary_fr, &MigelItem::secondary_it};
+    const List all[3] = {&MigelItem::all_keywords_de, &MigelItem::all_keywords_fr, &MigelItem::all_keywords_it};
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        MigelItem& item = items[tasks[i].item];
+        uint32_t l = tasks[i].lang;
+        item.*keywords[l] = std::move(extracted[i].keywords);
+        item.*secondary[l] = std::move(extracted[i].secondary);
+        auto& all_kw = item.*all[l];
+        if (all_kw.empty()) {
+            all_kw = std::move(extracted[i].all);
+            continue;
+        }
+        auto mid = static_cast<std::ptrdiff_t>(all_kw.size());
+        all_kw.insert(all_kw.end(), std::make_move_iterator(extracted[i].all.begin()),
+                      std::make_move_iterator(extracted[i].all.end()));
+        std::inplace_merge(all_kw.begin(), all_kw.begin() + mid, all_kw.end());
+        all_kw.erase(std::unique(all_kw.begin(), all_kw.end()), all_kw.end());
+    }
+
+    // Intern all keyword lists (sequentially: ids are assigned in first-seen order)
+    for (auto& item : items) {
+        item.ids_de = intern_keywords(tokens, item.keywords_de);
+        item.ids_fr = intern_keywords(tokens, item.keywords_fr);
+        item.ids_it = intern_keywords(tokens, item.keywords_it);
+        item.secondary_ids_de = intern_keywords(tokens, item.secondary_de);
+        item.secondary_ids_fr = intern_keywords(tokens, item.secondary_fr);
+        item.secondary_ids_it = intern_keywords(tokens, item.secondary_it);
+        item.all_ids_de = intern_keywords(tokens, item.all_keywords_de);
+        item.all_ids_fr = intern_keywords(tokens, item.all_keywords_fr);
+        item.all_ids_it = intern_keywords(tokens, item.all_keywords_it);
+    }
+
+    return items;
+}
+
+/// Parse MiGeL items from CSV files (one per language sheet), read concurrently.
+/// tokens: receives the ids of all catalog keywords (MigelItem::ids_* refer to it)
 /// csv_de: German sheet CSV (required)
 /// csv_fr: French sheet CSV (optional, pass "" to skip)
 /// csv_it: Italian sheet CSV (optional, pass "" to skip)
 inline std::vector<MigelItem> parse_migel_items(
+    TokenDict& tokens,
     const std::string& csv_de,
     const std::string& csv_fr = "",
     const std::string& csv_it = "")
 {
-    // --- Pass 1: Parse German sheet ---
-    auto rows_de = parse_csv_sheet(csv_de);
-    std::vector<MigelItem> items;
+    std::array<SheetRows, 3> sheets;
+    const std::string* paths[3] = {&csv_de, &csv_fr, &csv_it};
+    std::vector<std::thread> readers;
+    for (int l = 1; l < 3; ++l)
+        if (!paths[l]->empty())
+            readers.emplace_back([&sheets, &paths, l] { sheets[l] = parse_csv_sheet(*paths[l]); });
+    sheets[0] = parse_csv_sheet(csv_de);
+    for (auto& t : readers) t.join();
+    return build_migel_items(tokens, sheets);
+}
 
-    for (const auto& [pos_nr, bezeichnung, limitation] : rows_de) {
-        if (pos_nr.empty()) continue; // category header row
+// ------------------------------ Flat arrays ----------------------------------
+
+/// Read-only array of trivially copyable elements that either owns them (filled by a
+/// builder as a std::vector) or views memory owned elsewhere, e.g. a mapped catalog
+/// snapshot (migel_snapshot.hpp). Movable, not copyable.
+template <class T>
+class FlatArray {
+public:
+    FlatArray() = default;
+    FlatArray(std::vector<T>&& v) : owned_(std::move(v)), view_(owned_) {}
+    FlatArray(const FlatArray&) = delete;
+    FlatArray& operator=(const FlatArray&) = delete;
+    FlatArray(FlatArray&& o) noexcept : owned_(std::move(o.owned_)), view_(std::exchange(o.view_, {})) {}
+    FlatArray& operator=(FlatArray&& o) noexcept {
+        owned_ = std::move(o.owned_);
+        view_ = std::exchange(o.view_, {});
+        return *this;
+    }
+
+    /// Non-owning array over s; the memory must outlive it.
+    static FlatArray view(std::span<const T> s) {
+        FlatArray a;
+        a.view_ = s;
+        return a;
+    }
+
+    const T& operator[](size_t i) const { return view_[i]; }
+    const T* data() const { return view_.data(); }
+    size_t size() const { return view_.size(); }
+    bool empty() const { return view_.empty(); }
+    const T* begin() const { return view_.data(); }
+    const T* end() const { return view_.data() + view_.size(); }
+    std::span<const T> span() const { return view_; }
+
+private:
+    std::vector<T> owned_;
+    std::span<const T> view_;
+};
+
+/// Item index in postings lists. Two bytes keep the postings of a catalog of a few
+/// thousand items in L2; check_item_count() rejects larger catalogs.
+using ItemId = uint16_t;
 
-        std::string fl = first_line(bezeichnung);
-        auto keywords_de = extract_keywords(fl);
-        auto secondary_de = extract_secondary_keywords(bezeichnung);
+inline void check_item_count(size_t items) {
+    if (items > UINT16_MAX) throw std::length_error("MiGeL catalog has more than 65535 items");
+}
 
-        auto all_kw = extract_keywords_full(bezeichnung);
-        if (!limitation.empty()) {
-            auto lim_kw = extract_keywords_full(limitation);
-            all_kw.insert(all_kw.end(), lim_kw.begin(), lim_kw.end());
-            std::sort(all_kw.begin(), all_kw.end());
-            all_kw.erase(std::unique(all_kw.begin(), all_kw.end()), all_kw.end());
+/// Open-addressing hash table from key text to dense ids 0..n-1 whose text lives
+/// elsewhere (e.g. a catalog arena): one uint32 slot per entry (id + 1, 0 = empty),
+/// linear probing, load factor <= 1/2. key_of(id) returns the text of id.
+class KeyTable {
+public:
+    template <class KeyFn>
+    void build(uint32_t count, KeyFn&& key_of) {
+        size_t size = 16;
+        while (size < 2 * static_cast<size_t>(count)) size *= 2;
+        slots_.assign(size, 0);
+        mask_ = size - 1;
+        for (uint32_t id = 0; id < count; ++id) {
+            size_t i = hash(key_of(id)) & mask_;
+            while (slots_[i] != 0) i = (i + 1) & mask_;
+            slots_[i] = id + 1;
         }
+    }
 
-        MigelItem item;
-        item.position_nr = pos_nr;
-        item.bezeichnung = std::move(fl);
-        item.limitation = limitation;
-        item.keywords_de = std::move(keywords_de);
-        item.secondary_de = std::move(secondary_de);
-        item.all_keywords = std::move(all_kw);
-        items.push_back(std::move(item));
+    /// Id of key, or UINT32_MAX.
+    template <class KeyFn>
+    uint32_t find(std::string_view key, KeyFn&& key_of) const {
+        if (slots_.empty()) return UINT32_MAX;
+        for (size_t i = hash(key) & mask_;; i = (i + 1) & mask_) {
+            uint32_t slot = slots_[i];
+            if (slot == 0) return UINT32_MAX;
+            if (key_of(slot - 1) == key) return slot - 1;
+        }
     }
 
-    // --- Pass 2: Parse French and Italian sheets ---
-    std::unordered_map<std::string, size_t> pos_map;
-    for (size_t i = 0; i < items.size(); ++i)
-        pos_map[items[i].position_nr] = i;
+private:
+    static size_t hash(std::string_view s) { return std::hash<std::string_view>{}(s); }
 
-    auto process_lang_sheet = [&](const std::string& path, int lang) {
-        if (path.empty()) return;
-        auto rows = parse_csv_sheet(path);
-        for (const auto& [pos_nr, bezeichnung, limitation] : rows) {
-            if (pos_nr.empty()) continue;
-            auto it = pos_map.find(pos_nr);
-            if (it == pos_map.end()) continue;
+    std::vector<uint32_t> slots_;
+    size_t mask_ = 0;
+};
 
-            size_t item_idx = it->second;
-            auto kw = extract_keywords(bezeichnung);
-            auto secondary = extract_secondary_keywords(bezeichnung);
+// ------------------------------ Keyword automaton ----------------------------
+
+/// Aho-Corasick automaton over all index keywords plus their 1-char-truncated
+/// fuzzy variants (keywords >= 7 chars). A single pass over a text reports every
+/// keyword for which fuzzy_contains(text, keyword) is true. The keywords may be split
+/// into disjoint groups (one per language), each with its own root: states 0..groups-1,
+/// and a pass from root g only reports keywords of group g.
+struct KeywordAutomaton {
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    /// Byte -> dense class; class 0 = byte occurs in no keyword (always back to root).
+    std::array<uint8_t, 256> byte_class{};
+    uint32_t stride = 1;
+    /// Complete DFA: next[state * stride + class] -> state.
+    FlatArray<uint32_t> next;
+    /// First state on the failure chain (including itself) that has outputs, or NONE.
+    FlatArray<uint32_t> first_out;
+    /// For an output state: the next output state further down its failure chain.
+    FlatArray<uint32_t> next_out;
+    /// Own outputs of each state (keyword ids), CSR layout: out_begin has states + 1 entries.
+    FlatArray<uint32_t> out_begin;
+    FlatArray<uint32_t> out_ids;
+
+    /// Call f(keyword_id) for every keyword of group root whose text or fuzzy variant
+    /// occurs in text. The same id may be reported more than once.
+    template <class F>
+    void for_each_match(uint32_t root, std::string_view text, F&& f) const {
+        uint32_t s = root;
+        for (unsigned char c : text) {
+            s = next[s * stride + byte_class[c]];
+            for (uint32_t o = first_out[s]; o != NONE; o = next_out[o])
+                for (uint32_t k = out_begin[o]; k < out_begin[o + 1]; ++k) f(out_ids[k]);
+        }
+    }
+};
 
-            if (lang == 1) {
-                items[item_idx].keywords_fr = std::move(kw);
-                items[item_idx].secondary_fr = std::move(secondary);
-            } else if (lang == 2) {
-                items[item_idx].keywords_it = std::move(kw);
-                items[item_idx].secondary_it = std::move(secondary);
+/// Build the automaton; keyword ids are positions in keywords, and group g holds the
+/// ids [group_begin[g], group_begin[g + 1]).
+inline KeywordAutomaton build_keyword_automaton(const std::vector<std::string>& keywords,
+                                                std::span<const uint32_t> group_begin) {
+    KeywordAutomaton ac;
+    constexpr uint32_t NONE = KeywordAutomaton::NONE;
+
+    uint32_t classes = 1;
+    for (const auto& kw : keywords)
+        for (unsigned char c : kw)
+            if (ac.byte_class[c] == 0) ac.byte_class[c] = static_cast<uint8_t>(classes++);
+    ac.stride = classes;
+
+    // One trie per group; 0 doubles as "no edge" since a root is never a child.
+    size_t roots = group_begin.size() - 1;
+    std::vector<uint32_t> next(roots * ac.stride, 0), first_out, next_out, out_begin, out_ids;
+    std::vector<std::vector<uint32_t>> own(roots);
+    auto add_pattern = [&](const std::string& pat, size_t len, uint32_t id, uint32_t root) {
+        uint32_t s = root;
+        for (size_t i = 0; i < len; ++i) {
+            size_t slot = s * ac.stride + ac.byte_class[static_cast<unsigned char>(pat[i])];
+            if (next[slot] == 0) {
+                uint32_t child = static_cast<uint32_t>(own.size());
+                own.emplace_back();
+                next.resize(next.size() + ac.stride, 0);
+                next[slot] = child;
             }
+            s = next[slot];
+        }
+        own[s].push_back(id);
+    };
+    for (uint32_t g = 0; g < roots; ++g) {
+        for (uint32_t i = group_begin[g]; i < group_begin[g + 1]; ++i) {
+            const auto& kw = keywords[i];
+            add_pattern(kw, kw.size(), i, g);
+            if (kw.size() >= 7) add_pattern(kw, kw.size() - 1, i, g);
+        }
+    }
+
+    size_t states = own.size();
+    out_begin.assign(states + 1, 0);
+    for (size_t s = 0; s < states; ++s) {
+        out_begin[s + 1] = out_begin[s] + static_cast<uint32_t>(own[s].size());
+        out_ids.insert(out_ids.end(), own[s].begin(), own[s].end());
+    }
 
-            auto full_kw = extract_keywords_full(bezeichnung);
-            items[item_idx].all_keywords.insert(
-                items[item_idx].all_keywords.end(), full_kw.begin(), full_kw.end());
-            if (!limitation.empty()) {
-                auto lim_kw = extract_keywords_full(limitation);
-                items[item_idx].all_keywords.insert(
-                    items[item_idx].all_keywords.end(), lim_kw.begin(), lim_kw.end());
+    // BFS: failure links, output links, and completion of the transition table.
+    std::vector<uint32_t> fail(states, 0);
+    first_out.assign(states, NONE);
+    next_out.assign(states, NONE);
+    std::vector<uint32_t> queue;
+    queue.reserve(states);
+    for (uint32_t r = 0; r < roots; ++r) {
+        for (uint32_t c = 0; c < ac.stride; ++c) {
+            uint32_t& slot = next[r * ac.stride + c];
+            if (slot != 0) {
+                fail[slot] = r;
+                queue.push_back(slot);
+            } else {
+                slot = r;
             }
         }
-    };
+    }
+    for (size_t qi = 0; qi < queue.size(); ++qi) {
+        uint32_t s = queue[qi];
+        next_out[s] = first_out[fail[s]];
+        first_out[s] = own[s].empty() ? next_out[s] : s;
+        for (uint32_t c = 0; c < ac.stride; ++c) {
+            uint32_t& slot = next[s * ac.stride + c];
+            uint32_t via_fail = next[fail[s] * ac.stride + c];
+            if (slot != 0) {
+                fail[slot] = via_fail;
+                queue.push_back(slot);
+            } else {
+                slot = via_fail;
+            }
+        }
+    }
+    ac.next = std::move(next);
+    ac.first_out = std::move(first_out);
+    ac.next_out = std::move(next_out);
+    ac.out_begin = std::move(out_begin);
+    ac.out_ids = std::move(out_ids);
+    return ac;
+}
 
-    process_lang_sheet(csv_fr, 1);
-    process_lang_sheet(csv_it, 2);
+// ------------------------------ Trigram index -------------------------------
 
-    // Deduplicate all_keywords per item
-    for (auto& item : items) {
-        std::sort(item.all_keywords.begin(), item.all_keywords.end());
-        item.all_keywords.erase(
-            std::unique(item.all_keywords.begin(), item.all_keywords.end()),
-            item.all_keywords.end());
+/// Three bytes packed into a key.
+inline uint32_t trigram_key(const char* p) {
+    return static_cast<uint32_t>(static_cast<unsigned char>(p[0])) << 16 |
+           static_cast<uint32_t>(static_cast<unsigned char>(p[1])) << 8 |
+           static_cast<uint32_t>(static_cast<unsigned char>(p[2]));
+}
+
+/// Distinct trigrams of a word, sorted, into out.
+template <class Vec>
+inline void word_trigrams(std::string_view w, Vec& out) {
+    out.clear();
+    for (size_t i = 0; i + 3 <= w.size(); ++i) out.push_back(trigram_key(w.data() + i));
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+/// Trigram postings over the index keywords (all keywords have >= 3 chars). A device
+/// word that contains a keyword, or its 1-char truncation for keywords >= 7 chars,
+/// contains at least fuzzy_trigrams[k] of the keyword's trigrams, so counting
+/// postings per word finds every keyword word_match() can accept. Keys carry the
+/// keyword group (language) above the 24 trigram bits, see group_key().
+struct TrigramIndex {
+    FlatArray<uint32_t> keys;            // distinct group keys, ascending
+    FlatArray<uint32_t> begin;           // key slot -> keywords slice (+1 sentinel)
+    FlatArray<uint32_t> keywords;        // keyword ids containing the trigram
+    FlatArray<uint16_t> trigrams;        // keyword id -> number of distinct trigrams
+    FlatArray<uint16_t> fuzzy_trigrams;  // ... of its truncation (>= 7 chars), else trigrams
+
+    static uint32_t group_key(uint32_t group, uint32_t trigram) { return group << 24 | trigram; }
+
+    /// Slot of key in keys, or UINT32_MAX.
+    uint32_t find(uint32_t key) const {
+        const uint32_t* it = std::lower_bound(keys.begin(), keys.end(), key);
+        return it != keys.end() && *it == key ? static_cast<uint32_t>(it - keys.begin()) : UINT32_MAX;
     }
 
-    return items;
+    std::span<const uint32_t> postings(uint32_t slot) const {
+        return keywords.span().subspan(begin[slot], begin[slot + 1] - begin[slot]);
+    }
+};
+
+/// Build the trigram index; keyword ids are positions in keywords, and group g holds
+/// the ids [group_begin[g], group_begin[g + 1]).
+inline TrigramIndex build_trigram_index(const std::vector<std::string>& keywords,
+                                        std::span<const uint32_t> group_begin) {
+    std::vector<std::pair<uint32_t, uint32_t>> pairs; // (group key, keyword id)
+    std::vector<uint16_t> trigrams, fuzzy_trigrams;
+    std::vector<uint32_t> tri;
+    uint32_t group = 0;
+    for (uint32_t k = 0; k < keywords.size(); ++k) {
+        while (k >= group_begin[group + 1]) ++group;
+        const std::string& kw = keywords[k];
+        if (kw.size() >= 7) {
+            word_trigrams(std::string_view(kw).substr(0, kw.size() - 1), tri);
+            fuzzy_trigrams.push_back(static_cast<uint16_t>(tri.size()));
+        }
+        word_trigrams(kw, tri);
+        trigrams.push_back(static_cast<uint16_t>(tri.size()));
+        if (kw.size() < 7) fuzzy_trigrams.push_back(static_cast<uint16_t>(tri.size()));
+        for (uint32_t t : tri) pairs.emplace_back(TrigramIndex::group_key(group, t), k);
+    }
+    std::sort(pairs.begin(), pairs.end());
+
+    std::vector<uint32_t> keys, begin, ids;
+    ids.reserve(pairs.size());
+    for (const auto& [t, k] : pairs) {
+        if (keys.empty() || keys.back() != t) {
+            keys.push_back(t);
+            begin.push_back(static_cast<uint32_t>(ids.size()));
+        }
+        ids.push_back(k);
+    }
+    begin.push_back(static_cast<uint32_t>(ids.size()));
+
+    TrigramIndex index;
+    index.keys = std::move(keys);
+    index.begin = std::move(begin);
+    index.keywords = std::move(ids);
+    index.trigrams = std::move(trigrams);
+    index.fuzzy_trigrams = std::move(fuzzy_trigrams);
+    return index;
 }
 
 // ------------------------------ Keyword index --------------------------------
 
-/// Build an inverted index: keyword -> list of MigelItem indices.
-inline std::unordered_map<std::string, std::vector<size_t>>
-build_keyword_index(const std::vector<MigelItem>& items) {
-    std::unordered_map<std::string, std::vector<size_t>> index;
-    for (size_t i = 0; i < items.size(); ++i) {
-        for (const auto& kw : items[i].all_keywords) {
-            index[kw].push_back(i);
+/// Inverted index: keyword id -> MigelItem indices, plus the automaton (substring
+/// prefilter) and trigram index (trigram prefilter) used to find which keyword ids
+/// occur in a product text. Keywords are indexed per language sheet (all_keywords_de,
+/// _fr, _it): a keyword of two sheets has one id in each, and the automaton root and
+/// trigram group of language l (0 DE, 1 FR, 2 IT) only reach that sheet's keywords,
+/// so each language channel is probed against its own keywords only. Postings are
+/// ascending ItemIds in one array (CSR layout);
+/// lists longer than 1/16 of the catalog are item bitmaps instead, which are smaller
+/// then and merge into a candidate bitmap a 64-bit word at a time.
+struct KeywordIndex {
+    static constexpr uint32_t SPARSE = UINT32_MAX;
+
+    size_t item_count = 0;
+    FlatArray<uint32_t> posting_begin; // keyword id -> posting_items slice (+1 sentinel), empty if dense
+    FlatArray<ItemId> posting_items;
+    FlatArray<uint32_t> posting_bitmap; // keyword id -> bitmap number, or SPARSE
+    FlatArray<uint64_t> bitmaps;        // bitmap_words() words per bitmap
+    KeywordAutomaton automaton;
+    TrigramIndex trigrams;
+
+    size_t size() const { return posting_begin.empty() ? 0 : posting_begin.size() - 1; }
+    size_t bitmap_words() const { return (item_count + 63) / 64; }
+
+    /// Set the bits of keyword kw's items in candidates (bitmap_words() words).
+    void add_postings(uint32_t kw, std::span<uint64_t> candidates) const {
+        if (uint32_t b = posting_bitmap[kw]; b != SPARSE) {
+            const uint64_t* bits = bitmaps.data() + b * bitmap_words();
+            for (size_t w = 0; w < candidates.size(); ++w) candidates[w] |= bits[w];
+            return;
+        }
+        for (uint32_t k = posting_begin[kw]; k < posting_begin[kw + 1]; ++k)
+            candidates[posting_items[k] / 64] |= 1ULL << (posting_items[k] % 64);
+    }
+};
+
+/// Build the inverted index over all_keywords_de, _fr and _it of every item.
+inline KeywordIndex build_keyword_index(const std::vector<MigelItem>& items) {
+    check_item_count(items.size());
+    KeywordIndex index;
+    index.item_count = items.size();
+    size_t words = index.bitmap_words();
+    std::vector<std::string> keywords;
+    std::vector<uint32_t> lang_begin = {0}, posting_begin = {0}, posting_bitmap;
+    std::vector<ItemId> posting_items;
+    std::vector<uint64_t> bitmaps;
+
+    for (auto all : {&MigelItem::all_keywords_de, &MigelItem::all_keywords_fr, &MigelItem::all_keywords_it}) {
+        std::unordered_map<std::string, std::vector<size_t>> map;
+        for (size_t i = 0; i < items.size(); ++i) {
+            for (const auto& kw : items[i].*all) {
+                map[kw].push_back(i);
+            }
+        }
+        for (auto& [kw, indices] : map) {
+            keywords.push_back(kw);
+            if (indices.size() * 16 > items.size()) {
+                posting_bitmap.push_back(static_cast<uint32_t>(bitmaps.size() / words));
+                bitmaps.resize(bitmaps.size() + words, 0);
+                uint64_t* bits = bitmaps.data() + bitmaps.size() - words;
+                for (size_t i : indices) bits[i / 64] |= 1ULL << (i % 64);
+            } else {
+                posting_bitmap.push_back(KeywordIndex::SPARSE);
+                for (size_t i : indices) posting_items.push_back(static_cast<ItemId>(i));
+            }
+            posting_begin.push_back(static_cast<uint32_t>(posting_items.size()));
         }
+        lang_begin.push_back(static_cast<uint32_t>(keywords.size()));
     }
+
+    index.posting_begin = std::move(posting_begin);
+    index.posting_items = std::move(posting_items);
+    index.posting_bitmap = std::move(posting_bitmap);
+    index.bitmaps = std::move(bitmaps);
+    index.automaton = build_keyword_automaton(keywords, lang_begin);
+    index.trigrams = build_trigram_index(keywords, lang_begin);
     return index;
 }
 
+// ------------------------------ Compiled catalog ------------------------------
+
+/// Trie over reversed keywords for German compound suffix matching. A walk from the
+/// end of a device word reports every keyword that word_match(suffix=true, fuzzy=true)
+/// accepts for it: the keyword itself or its 1-char truncation (keywords >= 7 chars)
+/// equals the word, or is a suffix of it with more than 2 chars left over.
+struct SuffixTrie {
+    std::array<uint8_t, 256> byte_class{}; // 0 = byte occurs in no keyword
+    uint32_t stride = 1;
+    FlatArray<uint32_t> next;              // node * stride + class -> child, 0 = none
+    FlatArray<uint32_t> out_begin;         // per-node keyword ids, CSR (+1 sentinel)
+    FlatArray<uint32_t> out_ids;
+
+    /// Call f(keyword_id) for every keyword matching word; ids may repeat.
+    template <class F>
+    void for_each_match(std::string_view word, F&& f) const {
+        if (next.empty()) return;
+        size_t len = word.size();
+        uint32_t node = 0;
+        for (size_t depth = 1; depth <= len; ++depth) {
+            uint8_t c = byte_class[static_cast<unsigned char>(word[len - depth])];
+            if (c == 0) return;
+            node = next[node * stride + c];
+            if (node == 0) return;
+            if (depth == len || len > depth + 2)
+                for (uint32_t k = out_begin[node]; k < out_begin[node + 1]; ++k) f(out_ids[k]);
+        }
+    }
+};
+
+/// Build the trie from (keyword id, keyword text) pairs. truncations = false leaves out
+/// the 1-char-truncated variants (for already stemmed keywords).
+template <class TokenFn>
+inline SuffixTrie build_suffix_trie(const std::vector<uint32_t>& ids, TokenFn&& token_of,
+                                    bool truncations = true) {
+    SuffixTrie trie;
+    uint32_t classes = 1;
+    for (uint32_t id : ids)
+        for (unsigned char c : std::string_view(token_of(id)))
+            if (trie.byte_class[c] == 0) trie.byte_class[c] = static_cast<uint8_t>(classes++);
+    trie.stride = classes;
+
+    std::vector<uint32_t> next(trie.stride, 0), out_begin, out_ids;
+    std::vector<std::vector<uint32_t>> own = {{}};
+    auto add_reversed = [&](std::string_view pat, uint32_t id) {
+        uint32_t node = 0;
+        for (size_t i = pat.size(); i-- > 0;) {
+            size_t slot = node * trie.stride + trie.byte_class[static_cast<unsigned char>(pat[i])];
+            if (next[slot] == 0) {
+                next[slot] = static_cast<uint32_t>(own.size());
+                own.emplace_back();
+                next.resize(next.size() + trie.stride, 0);
+            }
+            node = next[slot];
+        }
+        own[node].push_back(id);
+    };
+    for (uint32_t id : ids) {
+        std::string_view kw = token_of(id);
+        add_reversed(kw, id);
+        if (truncations && kw.size() >= 7) add_reversed(kw.substr(0, kw.size() - 1), id);
+    }
+
+    out_begin.assign(own.size() + 1, 0);
+    for (size_t n = 0; n < own.size(); ++n) {
+        out_begin[n + 1] = out_begin[n] + static_cast<uint32_t>(own[n].size());
+        out_ids.insert(out_ids.end(), own[n].begin(), own[n].end());
+    }
+    trie.next = std::move(next);
+    trie.out_begin = std::move(out_begin);
+    trie.out_ids = std::move(out_ids);
+    return trie;
+}
+
+/// Keyword lists per item: primary DE/FR/IT, then secondary DE/FR/IT.
+enum KeywordList : uint8_t { KW_DE, KW_FR, KW_IT, SEC_DE, SEC_FR, SEC_IT, KW_LIST_COUNT };
+
+/// Matched-keyword mask of one list: bit i = the list's i-th longest keyword (see
+/// CompiledCatalog::list_weight); the top bit also stands for every keyword past it
+/// (the list is then scored without the mask).
+inline constexpr size_t MASK_BITS = 64;
+inline constexpr uint64_t MASK_OVERFLOW = 1ULL << (MASK_BITS - 1);
+
+/// Bit of a token in a 64-bit keyword signature (Fibonacci hash of the id).
+inline uint64_t token_bit(uint32_t id) {
+    return 1ULL << ((id * 0x9E3779B97F4A7C15ULL) >> 58);
+}
+
+/// Hashed bit sets of one item's keywords in one language. Intersected with the
+/// signature of the device's matched keywords they reject candidates that cannot pass
+/// with a few AND/popcount instructions (see signature_can_pass()).
+struct KeywordSignature {
+    uint64_t primary = 0;
+    uint64_t secondary = 0;
+    uint64_t len6 = 0;            // primary + secondary keywords >= 6 chars
+    uint64_t len10 = 0;           // primary + secondary keywords >= 10 chars
+    bool distinct_bits = false;   // no two keywords of one list share a bit
+};
+
+/// Stemmed keywords for Morphology::STEM. DE keyword stems sit in a reversed-suffix
+/// trie (equal or compound suffix, no truncation variants); FR and IT keyword stems
+/// are keys ('f' or 'i' + stem) that map to every token id sharing that stem.
+struct StemIndex {
+    SuffixTrie de_suffixes;
+    FlatArray<char> arena;           // key text
+    FlatArray<uint32_t> key_begin;   // key id -> arena offset (+1 sentinel)
+    FlatArray<uint32_t> token_begin; // key id -> tokens slice (+1 sentinel)
+    FlatArray<uint32_t> tokens;
+    KeyTable key_ids;                // key text -> key id, see index_keys()
+
+    std::string_view key(uint32_t k) const {
+        return {arena.data() + key_begin[k], key_begin[k + 1] - key_begin[k]};
+    }
+
+    /// Token ids whose stem key is key (empty if none).
+    std::span<const uint32_t> lookup(std::string_view key) const {
+        uint32_t k = key_ids.find(key, [&](uint32_t id) { return this->key(id); });
+        if (k == UINT32_MAX) return {};
+        return tokens.span().subspan(token_begin[k], token_begin[k + 1] - token_begin[k]);
+    }
+
+    void index_keys() {
+        auto keys = static_cast<uint32_t>(key_begin.empty() ? 0 : key_begin.size() - 1);
+        key_ids.build(keys, [&](uint32_t k) { return key(k); });
+    }
+};
+
+/// Flat struct-of-arrays form of the catalog used by the matcher.
+/// Keyword text lives in one char arena (token id -> offset/length); each item's six
+/// keyword lists are slices of list_ids, and their weight totals (sum of keyword
+/// lengths) and longest keyword are precomputed. Lists are ordered rarest keyword
+/// first so that score bounds tighten quickly while probing. DE keywords (primary and
+/// secondary) are additionally indexed in a reversed-suffix trie.
+struct CompiledCatalog {
+    FlatArray<char> arena;
+    FlatArray<uint32_t> token_offset;            // token id -> offset into arena
+    FlatArray<uint32_t> token_len;               // token id -> keyword length
+    KeyTable token_ids;                          // keyword text -> token id, see index_tokens()
+
+    size_t item_count = 0;
+    FlatArray<uint32_t> list_begin;              // item * KW_LIST_COUNT + list -> list_ids slice (+1 sentinel)
+    FlatArray<uint32_t> list_ids;                // token ids, rarest (lowest token_df) first per list
+    FlatArray<uint32_t> list_weight;             // per list: keyword lengths, longest first (mask bit order)
+    FlatArray<uint32_t> list_total;              // per list: sum of keyword lengths
+    FlatArray<uint32_t> list_max_len;            // per list: longest keyword
+    FlatArray<uint32_t> token_df;                // token id -> number of keyword lists containing it
+    /// item * 3 + language (DE, FR, IT) -> lowest score with which that language can
+    /// pass the match criteria (0.3 or 0.5), or 2.0 if its keywords can never pass.
+    FlatArray<double> pass_floor;
+    FlatArray<KeywordSignature> signatures;      // item * 3 + language
+    SuffixTrie de_suffixes;
+    /// Column view of the six keyword lists (items x tokens, length-weighted) for
+    /// Scoring::SPARSE: list * token count + token id -> column_items slice (+1
+    /// sentinel), the items whose list contains the token, ascending, once per
+    /// occurrence. column_bits holds the token's bit in that item's matched-keyword
+    /// mask (its length rank in the list, capped at MASK_BITS - 1).
+    FlatArray<uint32_t> column_begin;
+    FlatArray<ItemId> column_items;
+    FlatArray<uint8_t> column_bits;
+    StemIndex stems;
+
+    CompiledCatalog() = default;
+    CompiledCatalog(const CompiledCatalog&) = delete;            // arrays may view a snapshot
+    CompiledCatalog& operator=(const CompiledCatalog&) = delete;
+    CompiledCatalog(CompiledCatalog&&) = default;
+    CompiledCatalog& operator=(CompiledCatalog&&) = default;
+
+    std::string_view token(uint32_t id) const {
+        return {arena.data() + token_offset[id], token_len[id]};
+    }
+
+    uint32_t lookup(std::string_view word) const {
+        return token_ids.find(word, [&](uint32_t id) { return token(id); });
+    }
+
+    size_t slot(size_t item, KeywordList list) const { return item * KW_LIST_COUNT + list; }
+
+    /// (Re)build token_ids from the arena.
+    void index_tokens() {
+        token_ids.build(static_cast<uint32_t>(token_len.size()), [&](uint32_t id) { return token(id); });
+        stems.index_keys();
+    }
+
+    size_t column(KeywordList list, uint32_t id) const { return list * token_len.size() + id; }
+};
+
+/// Compile parse_migel_items() output (items and their TokenDict) into flat arrays.
+inline CompiledCatalog compile_catalog(const std::vector<MigelItem>& items, const TokenDict& tokens) {
+    check_item_count(items.size());
+    CompiledCatalog cat;
+    std::vector<char> arena;
+    std::vector<uint32_t> token_offset, token_len, list_begin, list_ids, list_total, list_max_len, token_df;
+    std::vector<double> pass_floor;
+    std::vector<KeywordSignature> signatures;
+
+    size_t arena_size = 0;
+    for (const auto& t : tokens.tokens) arena_size += t.size();
+    arena.reserve(arena_size);
+    token_offset.reserve(tokens.size());
+    token_len.reserve(tokens.size());
+    for (const auto& t : tokens.tokens) {
+        token_offset.push_back(static_cast<uint32_t>(arena.size()));
+        token_len.push_back(static_cast<uint32_t>(t.size()));
+        arena.insert(arena.end(), t.begin(), t.end());
+    }
+    cat.item_count = items.size();
+    size_t slots = items.size() * KW_LIST_COUNT;
+    list_begin.reserve(slots + 1);
+    list_total.reserve(slots);
+    list_max_len.reserve(slots);
+    list_begin.push_back(0);
+    auto lists_of = [](const MigelItem& item) {
+        return std::array<const std::vector<uint32_t>*, KW_LIST_COUNT>{
+            &item.ids_de, &item.ids_fr, &item.ids_it,
+            &item.secondary_ids_de, &item.secondary_ids_fr, &item.secondary_ids_it,
+        };
+    };
+    token_df.assign(tokens.size(), 0);
+    for (const auto& item : items)
+        for (const auto* ids : lists_of(item))
+            for (uint32_t id : *ids) ++token_df[id];
+    auto rarest_first = [&](uint32_t a, uint32_t b) {
+        if (token_df[a] != token_df[b]) return token_df[a] < token_df[b];
+        if (token_len[a] != token_len[b]) return token_len[a] > token_len[b];
+        return a < b;
+    };
+    for (const auto& item : items) {
+        for (const auto* ids : lists_of(item)) {
+            uint32_t total = 0, max_len = 0;
+            for (uint32_t id : *ids) {
+                total += token_len[id];
+                max_len = std::max(max_len, token_len[id]);
+            }
+            size_t begin = list_ids.size();
+            list_ids.insert(list_ids.end(), ids->begin(), ids->end());
+            std::sort(list_ids.begin() + begin, list_ids.end(), rarest_first);
+            list_begin.push_back(static_cast<uint32_t>(list_ids.size()));
+            list_total.push_back(total);
+            list_max_len.push_back(max_len);
+        }
+    }
+
+    // Pass floors: count >= 2 needs score >= 0.3 and max_len >= 6, otherwise score >= 0.5
+    // and max_len >= 10 (secondary keywords count toward both).
+    pass_floor.reserve(items.size() * 3);
+    for (size_t i = 0; i < items.size(); ++i) {
+        for (int l = 0; l < 3; ++l) {
+            size_t prim = cat.slot(i, static_cast<KeywordList>(KW_DE + l));
+            size_t sec = cat.slot(i, static_cast<KeywordList>(SEC_DE + l));
+            size_t count = (list_begin[prim + 1] - list_begin[prim]) +
+                           (list_begin[sec + 1] - list_begin[sec]);
+            uint32_t reach = std::max(list_max_len[prim], list_max_len[sec]);
+            double floor = 2.0;
+            if (count >= 2 && reach >= 6) floor = 0.3;
+            else if (reach >= 10) floor = 0.5;
+            pass_floor.push_back(floor);
+        }
+    }
+
+    signatures.reserve(items.size() * 3);
+    for (size_t i = 0; i < items.size(); ++i) {
+        for (int l = 0; l < 3; ++l) {
+            KeywordSignature sig;
+            sig.distinct_bits = true;
+            for (KeywordList list : {static_cast<KeywordList>(KW_DE + l), static_cast<KeywordList>(SEC_DE + l)}) {
+                size_t slot = cat.slot(i, list);
+                uint64_t& bits = list < SEC_DE ? sig.primary : sig.secondary;
+                for (uint32_t k = list_begin[slot]; k < list_begin[slot + 1]; ++k) {
+                    uint32_t id = list_ids[k];
+                    uint64_t bit = token_bit(id);
+                    if (bits & bit) sig.distinct_bits = false;
+                    bits |= bit;
+                    if (token_len[id] >= 6) sig.len6 |= bit;
+                    if (token_len[id] >= 10) sig.len10 |= bit;
+                }
+            }
+            signatures.push_back(sig);
+        }
+    }
+
+    // Mask bits: list entries ranked longest first
+    std::vector<uint32_t> list_weight(list_ids.size()), list_rank(list_ids.size());
+    for (size_t slot = 0; slot < slots; ++slot) {
+        uint32_t begin = list_begin[slot], end = list_begin[slot + 1];
+        std::vector<uint32_t> order(end - begin);
+        for (uint32_t r = 0; r < order.size(); ++r) order[r] = begin + r;
+        std::stable_sort(order.begin(), order.end(),
+                         [&](uint32_t a, uint32_t b) { return token_len[list_ids[a]] > token_len[list_ids[b]]; });
+        for (uint32_t r = 0; r < order.size(); ++r) {
+            list_weight[begin + r] = token_len[list_ids[order[r]]];
+            list_rank[order[r]] = r;
+        }
+    }
+
+    cat.arena = std::move(arena);
+    cat.token_offset = std::move(token_offset);
+    cat.token_len = std::move(token_len);
+    cat.list_begin = std::move(list_begin);
+    cat.list_ids = std::move(list_ids);
+    cat.list_weight = std::move(list_weight);
+    cat.list_total = std::move(list_total);
+    cat.list_max_len = std::move(list_max_len);
+    cat.token_df = std::move(token_df);
+    cat.pass_floor = std::move(pass_floor);
+    cat.signatures = std::move(signatures);
+    cat.index_tokens();
+
+    std::vector<uint32_t> de_ids;
+    for (const auto& item : items) {
+        de_ids.insert(de_ids.end(), item.ids_de.begin(), item.ids_de.end());
+        de_ids.insert(de_ids.end(), item.secondary_ids_de.begin(), item.secondary_ids_de.end());
+    }
+    std::sort(de_ids.begin(), de_ids.end());
+    de_ids.erase(std::unique(de_ids.begin(), de_ids.end()), de_ids.end());
+    cat.de_suffixes = build_suffix_trie(de_ids, [&](uint32_t id) { return cat.token(id); });
+
+    // Columns: transpose of list_ids per list
+    size_t token_count = tokens.size();
+    std::vector<uint32_t> column_begin(KW_LIST_COUNT * token_count + 1, 0);
+    std::vector<ItemId> column_items(cat.list_ids.size());
+    std::vector<uint8_t> column_bits(cat.list_ids.size());
+    for (size_t slot = 0; slot < slots; ++slot)
+        for (uint32_t k = cat.list_begin[slot]; k < cat.list_begin[slot + 1]; ++k)
+            ++column_begin[slot % KW_LIST_COUNT * token_count + cat.list_ids[k] + 1];
+    for (size_t c = 0; c + 1 < column_begin.size(); ++c) column_begin[c + 1] += column_begin[c];
+    {
+        std::vector<uint32_t> fill(column_begin.begin(), column_begin.end() - 1);
+        for (size_t slot = 0; slot < slots; ++slot)
+            for (uint32_t k = cat.list_begin[slot]; k < cat.list_begin[slot + 1]; ++k) {
+                uint32_t at = fill[slot % KW_LIST_COUNT * token_count + cat.list_ids[k]]++;
+                column_items[at] = static_cast<ItemId>(slot / KW_LIST_COUNT);
+                column_bits[at] = static_cast<uint8_t>(std::min<size_t>(list_rank[k], MASK_BITS - 1));
+            }
+    }
+    cat.column_begin = std::move(column_begin);
+    cat.column_items = std::move(column_items);
+    cat.column_bits = std::move(column_bits);
+
+    // Stems: DE trie over stem_de(keyword); FR/IT stem keys -> token ids
+    std::vector<std::string> de_stems(tokens.size());
+    for (uint32_t id : de_ids) de_stems[id] = stem_de(cat.token(id));
+    cat.stems.de_suffixes = build_suffix_trie(
+        de_ids, [&](uint32_t id) { return std::string_view(de_stems[id]); }, false);
+    std::vector<std::pair<std::string, uint32_t>> keyed; // (stem key, token id)
+    for (const auto& item : items) {
+        for (const auto* ids : {&item.ids_fr, &item.secondary_ids_fr})
+            for (uint32_t id : *ids) {
+                std::string key = "f";
+                stem_append(Lang::FR, cat.token(id), key);
+                keyed.emplace_back(std::move(key), id);
+            }
+        for (const auto* ids : {&item.ids_it, &item.secondary_ids_it})
+            for (uint32_t id : *ids) {
+                std::string key = "i";
+                stem_append(Lang::IT, cat.token(id), key);
+                keyed.emplace_back(std::move(key), id);
+            }
+    }
+    std::sort(keyed.begin(), keyed.end());
+    keyed.erase(std::unique(keyed.begin(), keyed.end()), keyed.end());
+    std::vector<char> stem_arena;
+    std::vector<uint32_t> key_begin = {0}, token_begin = {0}, stem_tokens;
+    for (size_t i = 0; i < keyed.size(); ++i) {
+        if (i == 0 || keyed[i].first != keyed[i - 1].first) {
+            if (i) token_begin.push_back(static_cast<uint32_t>(stem_tokens.size()));
+            stem_arena.insert(stem_arena.end(), keyed[i].first.begin(), keyed[i].first.end());
+            key_begin.push_back(static_cast<uint32_t>(stem_arena.size()));
+        }
+        stem_tokens.push_back(keyed[i].second);
+    }
+    if (!keyed.empty()) token_begin.push_back(static_cast<uint32_t>(stem_tokens.size()));
+    cat.stems.arena = std::move(stem_arena);
+    cat.stems.key_begin = std::move(key_begin);
+    cat.stems.token_begin = std::move(token_begin);
+    cat.stems.tokens = std::move(stem_tokens);
+    cat.stems.index_keys();
+    return cat;
+}
+
+/// Map device words to catalog ids into ids: sorted, unique, UNKNOWN dropped.
+inline void lookup_words(const CompiledCatalog& cat, std::span<const std::string_view> words,
+                         std::pmr::vector<uint32_t>& ids) {
+    ids.clear();
+    for (std::string_view w : words) {
+        uint32_t id = cat.lookup(w);
+        if (id != TokenDict::UNKNOWN) ids.push_back(id);
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+/// DE keyword ids matched by any device word under suffix + fuzzy rules, into ids
+/// (sorted, unique).
+inline void match_german_suffixes(const CompiledCatalog& cat, std::span<const std::string_view> words,
+                                  std::pmr::vector<uint32_t>& ids) {
+    ids.clear();
+    for (std::string_view w : words)
+        cat.de_suffixes.for_each_match(w, [&](uint32_t id) { ids.push_back(id); });
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+/// Keyword ids whose stem matches a device word's stem in language lang
+/// (Morphology::STEM), into ids (sorted, unique). DE stems also match as compound
+/// suffix. key is scratch space for FR/IT stem keys.
+template <class Vec, class Str>
+inline void match_stems(const CompiledCatalog& cat, Lang lang, std::span<const std::string_view> words,
+                        Vec& ids, Str& key) {
+    ids.clear();
+    for (std::string_view w : words) {
+        if (lang == Lang::DE) {
+            cat.stems.de_suffixes.for_each_match(stem_de(w), [&](uint32_t id) { ids.push_back(id); });
+            continue;
+        }
+        key.clear();
+        key.reserve(w.size() + 2);
+        key.push_back(lang == Lang::FR ? 'f' : 'i');
+        stem_append(lang, w, key);
+        for (uint32_t id : cat.stems.lookup(key)) ids.push_back(id);
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
 // ------------------------------ Matching -------------------------------------
 
 /// Check if a keyword matches in the text at word level.
 /// suffix: also match as suffix of compound word (German only)
 /// fuzzy: also try keyword truncated by 1 char (German plural/case)
 inline bool word_match(const std::vector<std::string>& text_words,
-                       const std::string& keyword, bool suffix, bool fuzzy) {
+                       std::string_view keyword, bool suffix, bool fuzzy) {
     for (const auto& word : text_words) {
         if (word == keyword) return true;
         if (suffix && word.size() > keyword.size() + 2 &&
@@ -554,7 +2007,7 @@ inline bool word_match(const std::vector<std::string>& text_words,
             return true;
     }
     if (fuzzy && keyword.size() >= 7) {
-        std::string trunc = keyword.substr(0, keyword.size() - 1);
+        std::string_view trunc = keyword.substr(0, keyword.size() - 1);
         for (const auto& word : text_words) {
             if (word == trunc) return true;
             if (suffix && word.size() > trunc.size() + 2 &&
@@ -565,7 +2018,8 @@ inline bool word_match(const std::vector<std::string>& text_words,
     return false;
 }
 
-/// Check if keyword matches anywhere in text as a substring (for candidate pre-filter).
+/// Check if keyword matches anywhere in text as a substring (candidate pre-filter
+/// semantics; KeywordAutomaton evaluates this for all keywords in one pass).
 inline bool fuzzy_contains(const std::string& haystack, const std::string& keyword) {
     if (haystack.find(keyword) != std::string::npos) return true;
     if (keyword.size() >= 7) {
@@ -603,95 +2057,832 @@ inline KeywordScore keyword_score(const std::vector<std::string>& text_words,
     return {matched_weight / total, max_matched_len, matched_count};
 }
 
-/// Find the best-matching MiGeL item for a product.
-/// Each language's keywords are scored ONLY against the same language's product description.
-inline const MigelItem* find_best_migel_match(
-    const std::string& desc_de,
-    const std::string& desc_fr,
-    const std::string& desc_it,
-    const std::string& brand,
-    const std::vector<MigelItem>& migel_items,
-    const std::unordered_map<std::string, std::vector<size_t>>& keyword_index)
-{
-    std::string de_lower = to_lower(normalize_german(desc_de + " " + brand));
-    std::string fr_lower = to_lower(normalize_german(desc_fr + " " + brand));
-    std::string it_lower = to_lower(normalize_german(desc_it + " " + brand));
-    std::string combined = de_lower + " " + fr_lower + " " + it_lower;
+/// Same score for one of an item's compiled keyword lists. token_match holds, per
+/// token id, a bit for each language whose device text matched that keyword
+/// (lookup_words() for exact matching, match_german_suffixes() for DE suffix/fuzzy).
+inline KeywordScore keyword_score(const CompiledCatalog& cat, size_t item, KeywordList list,
+                                  const std::vector<uint8_t>& token_match, uint8_t lang_bit) {
+    size_t slot = cat.slot(item, list);
+    if (cat.list_total[slot] == 0) return {0.0, 0, 0};
 
-    auto de_words = split_words(de_lower);
-    auto fr_words = split_words(fr_lower);
-    auto it_words = split_words(it_lower);
+    uint32_t matched_weight = 0;
+    size_t max_matched_len = 0;
+    size_t matched_count = 0;
 
-    // Step 1: Find candidate items via broad keyword index
-    std::unordered_set<size_t> candidates;
-    for (const auto& [keyword, indices] : keyword_index) {
-        if (fuzzy_contains(combined, keyword)) {
-            for (size_t idx : indices) candidates.insert(idx);
+    for (uint32_t i = cat.list_begin[slot]; i < cat.list_begin[slot + 1]; ++i) {
+        uint32_t k = cat.list_ids[i];
+        if (token_match[k] & lang_bit) {
+            uint32_t len = cat.token_len[k];
+            matched_weight += len;
+            matched_count++;
+            if (len > max_matched_len) max_matched_len = len;
         }
     }
+    return {static_cast<double>(matched_weight) / static_cast<double>(cat.list_total[slot]),
+            max_matched_len, matched_count};
+}
+
+/// keyword_score() from the list's matched-keyword mask (without MASK_OVERFLOW) and
+/// matched weight: popcount for the count, the lowest set bit for the longest keyword.
+inline KeywordScore keyword_score_mask(const CompiledCatalog& cat, size_t slot, uint64_t mask,
+                                       uint32_t matched_weight) {
+    if (mask == 0) return {0.0, 0, 0};
+    return {static_cast<double>(matched_weight) / static_cast<double>(cat.list_total[slot]),
+            cat.list_weight[cat.list_begin[slot] + std::countr_zero(mask)],
+            static_cast<size_t>(std::popcount(mask))};
+}
+
+/// keyword_score() that gives up as soon as the score can no longer reach bar
+/// (unmatched weight so far rules it out). Returns false in that case.
+inline bool keyword_score_bounded(const CompiledCatalog& cat, size_t item, KeywordList list,
+                                  const std::vector<uint8_t>& token_match, uint8_t lang_bit,
+                                  double bar, KeywordScore& out) {
+    size_t slot = cat.slot(item, list);
+    uint32_t total = cat.list_total[slot];
+    if (total == 0) return false;
+
+    uint32_t matched_weight = 0, reachable = total;
+    size_t max_matched_len = 0;
+    size_t matched_count = 0;
+
+    for (uint32_t i = cat.list_begin[slot]; i < cat.list_begin[slot + 1]; ++i) {
+        uint32_t k = cat.list_ids[i];
+        uint32_t len = cat.token_len[k];
+        if (token_match[k] & lang_bit) {
+            matched_weight += len;
+            matched_count++;
+            if (len > max_matched_len) max_matched_len = len;
+        } else {
+            reachable -= len;
+            if (static_cast<double>(reachable) / static_cast<double>(total) < bar) return false;
+        }
+    }
+    out = {static_cast<double>(matched_weight) / static_cast<double>(total),
+           max_matched_len, matched_count};
+    return true;
+}
+
+/// False if the language cannot pass the match criteria for this item, judged only
+/// from its signature and the device's matched-keyword signature: no primary keyword
+/// can match, nothing >= 6 chars can match, or (when bits are distinct, so popcount
+/// bounds the match count) at most one keyword can match and none is >= 10 chars.
+inline bool signature_can_pass(const KeywordSignature& sig, uint64_t device) {
+    if (!(sig.primary & device)) return false;
+    if (!(sig.len6 & device)) return false;
+    if (sig.distinct_bits && !(sig.len10 & device) &&
+        std::popcount(sig.primary & device) + std::popcount(sig.secondary & device) <= 1)
+        return false;
+    return true;
+}
+
+/// Dense membership set over [0, n): one generation stamp per element, so clearing
+/// is a counter increment and insert/contains are single array accesses.
+struct StampSet {
+    std::vector<uint32_t> stamp;
+    uint32_t generation = 0;
+
+    /// Empty the set and make room for elements [0, n).
+    void reset(size_t n) {
+        if (stamp.size() < n) stamp.resize(n, 0);
+        if (++generation == 0) { // wrapped: old stamps could alias the new generation
+            std::fill(stamp.begin(), stamp.end(), 0);
+            generation = 1;
+        }
+    }
+
+    /// Returns true if i was not yet in the set.
+    bool insert(size_t i) {
+        if (stamp[i] == generation) return false;
+        stamp[i] = generation;
+        return true;
+    }
+
+    bool contains(size_t i) const { return stamp[i] == generation; }
+};
+
+/// Counters over [0, n) that reset in O(1) like StampSet.
+struct StampCounter {
+    StampSet live;
+    std::vector<uint32_t> count;
+
+    void reset(size_t n) {
+        live.reset(n);
+        if (count.size() < n) count.resize(n);
+    }
+
+    /// Add one to counter i; returns the new value.
+    uint32_t increment(size_t i) {
+        if (live.insert(i)) count[i] = 0;
+        return ++count[i];
+    }
+};
+
+// ------------------------------ German decompounding --------------------------
+
+/// Splits German device words into DE catalog keywords ("kompressionsstrumpf" ->
+/// "kompression" + "strumpf"), so that the non-final parts of a compound count as
+/// keyword hits too (the suffix trie already covers the final part). The catalog's
+/// DE keywords (primary and secondary, >= MIN_PART chars) are the dictionary; a DP
+/// finds the segmentation of the whole word into the fewest keywords, allowing the
+/// linking elements -s-, -es-, -n-, -en- between parts. Words that do not split
+/// completely yield nothing. Results are cached in a fixed table of CACHE_SLOTS words
+/// (direct-mapped by text_hash(), a new word evicts the slot's old one), allocated
+/// once per Decompounder (one per Matcher, i.e. per worker thread): memory stays
+/// bounded over a full run and a lookup never allocates.
+class Decompounder {
+public:
+    static constexpr size_t MIN_PART = 4;
+    static constexpr size_t MAX_WORD = 64;
+    static constexpr size_t MAX_PARTS = MAX_WORD / MIN_PART;
+    static constexpr size_t CACHE_SLOTS = 4096; // power of two
+
+    explicit Decompounder(const CompiledCatalog& catalog)
+        : catalog_(catalog), is_part_(catalog.token_len.size(), 0), cache_(CACHE_SLOTS) {
+        for (size_t item = 0; item < catalog.item_count; ++item)
+            for (KeywordList list : {KW_DE, SEC_DE}) {
+                size_t slot = catalog.slot(item, list);
+                for (uint32_t k = catalog.list_begin[slot]; k < catalog.list_begin[slot + 1]; ++k) {
+                    uint32_t id = catalog.list_ids[k];
+                    if (catalog.token_len[id] >= MIN_PART) is_part_[id] = 1;
+                }
+            }
+    }
+
+    /// Keyword ids of word's parts (empty unless it splits into >= 2 keywords). The
+    /// span is only valid until the next call.
+    std::span<const uint32_t> split(std::string_view word) {
+        if (word.size() < 2 * MIN_PART || word.size() > MAX_WORD) return {};
+        Entry& e = cache_[text_hash(word) & (CACHE_SLOTS - 1)];
+        if (std::string_view(e.word.data(), e.len) != word) {
+            std::memcpy(e.word.data(), word.data(), word.size());
+            e.len = static_cast<uint8_t>(word.size());
+            e.count = segment(word, e.parts);
+        }
+        return std::span<const uint32_t>(e.parts.data(), e.count);
+    }
+
+private:
+    struct Entry {
+        uint8_t len = 0; // 0: empty slot (cached words have >= 2 * MIN_PART chars)
+        uint8_t count = 0;
+        std::array<char, MAX_WORD> word;
+        std::array<uint32_t, MAX_PARTS> parts; // last part first
+    };
+
+    /// Segment word into parts; returns the number of parts (0 if it does not split).
+    uint8_t segment(std::string_view word, std::array<uint32_t, MAX_PARTS>& parts) {
+        static constexpr std::string_view links[] = {"s", "es", "n", "en"};
+        constexpr uint32_t NONE = UINT32_MAX;
+        size_t n = word.size();
+        // best[i]: fewest parts covering word[0, i); from[i] / part[i]: start and
+        // keyword id of the last of them
+        std::array<uint32_t, MAX_WORD + 1> best, from, part;
+        best.fill(NONE);
+        best[0] = 0;
+        auto relax = [&](size_t to, size_t start, uint32_t id, uint32_t parts) {
+            if (parts < best[to]) {
+                best[to] = parts;
+                from[to] = static_cast<uint32_t>(start);
+                part[to] = id;
+            }
+        };
+        for (size_t i = 0; i + MIN_PART <= n; ++i) {
+            if (best[i] == NONE) continue;
+            for (size_t e = i + MIN_PART; e <= n; ++e) {
+                uint32_t id = catalog_.lookup(word.substr(i, e - i));
+                if (id == TokenDict::UNKNOWN || !is_part_[id]) continue;
+                relax(e, i, id, best[i] + 1);
+                for (std::string_view link : links)
+                    if (e + link.size() < n && word.compare(e, link.size(), link) == 0)
+                        relax(e + link.size(), i, id, best[i] + 1);
+            }
+        }
+        if (best[n] == NONE || best[n] < 2) return 0;
+        size_t count = 0;
+        for (size_t at = n; at > 0; at = from[at]) parts[count++] = part[at];
+        return static_cast<uint8_t>(count);
+    }
+
+    const CompiledCatalog& catalog_;
+    std::vector<uint8_t> is_part_; // token id -> usable as a compound part
+    std::vector<Entry> cache_;     // CACHE_SLOTS segmentations
+};
+
+// ------------------------------ Matcher ---------------------------------------
+
+/// Monotonic memory resource for per-device temporaries: allocation bumps a pointer in
+/// one reusable block and reset() rewinds it. Requests that do not fit go to the heap
+/// and make the next reset() grow the block, so the steady state never allocates.
+class ScratchArena : public std::pmr::memory_resource {
+public:
+    explicit ScratchArena(size_t initial_bytes = 64 * 1024) : block_(initial_bytes) {}
+
+    /// Release everything allocated since the last reset.
+    void reset() {
+        for (const auto& o : overflow_) ::operator delete(o.ptr, o.bytes, std::align_val_t(o.align));
+        if (!overflow_.empty()) block_.resize(2 * (used_ + overflow_bytes_));
+        overflow_.clear();
+        overflow_bytes_ = 0;
+        used_ = 0;
+    }
+
+private:
+    struct Overflow { void* ptr; size_t bytes; size_t align; };
+
+    void* do_allocate(size_t bytes, size_t align) override {
+        auto base = reinterpret_cast<uintptr_t>(block_.data());
+        size_t start = ((base + used_ + align - 1) & ~(uintptr_t(align) - 1)) - base;
+        if (start + bytes <= block_.size()) {
+            used_ = start + bytes;
+            return block_.data() + start;
+        }
+        void* p = ::operator new(bytes, std::align_val_t(align));
+        overflow_.push_back({p, bytes, align});
+        overflow_bytes_ += bytes;
+        return p;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {} // freed by reset()
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    std::vector<std::byte> block_;
+    size_t used_ = 0;
+    std::vector<Overflow> overflow_;
+    size_t overflow_bytes_ = 0;
+};
+
+/// One device's text, already routed per language channel. The views only need to
+/// stay valid for the duration of the match call.
+struct DeviceText {
+    std::string_view desc_de;
+    std::string_view desc_fr;
+    std::string_view desc_it;
+    std::string_view brand;
+};
+
+struct MatchOutcome {
+    const MigelItem* item = nullptr; // best MiGeL item, nullptr if none passes
+    double score = 0.0;              // keyword score of the winning language
+    size_t max_len = 0;              // longest keyword it matched
+    size_t candidates = 0;           // items the prefilter passed to scoring
+};
+
+/// Candidate prefilter. SUBSTRING: every index keyword occurring anywhere in the text
+/// (Aho-Corasick). TRIGRAM: every keyword sharing at least min_overlap of its trigrams
+/// with a single device word. Both keep every item that can pass, so the match result
+/// does not depend on the choice; only the number of candidates scored does. Used by
+/// Scoring::PRUNED and score_top_k().
+enum class Prefilter { SUBSTRING, TRIGRAM };
+
+/// How inflected forms match. TRUNCATION (default): DE keywords also match as compound
+/// suffixes and, from 7 chars, with their last char dropped; FR/IT match exactly.
+/// STEM: device words and keywords are compared after light stemming (stem_de/fr/it),
+/// DE still as compound suffix. STEM changes results; candidates then come from the
+/// matched tokens themselves, so the Prefilter setting does not apply.
+enum class Morphology { TRUNCATION, STEM };
+
+/// Scoring engine. SPARSE (default): the keyword lists are read column-wise
+/// (CompiledCatalog::column), so every matched token sets its bit in the matched-keyword
+/// mask of the items containing it and all items with a matched primary keyword are
+/// scored from their masks in one pass, without a prefilter. PRUNED: the prefilter's candidates are scored one by one,
+/// walking each keyword list with upper-bound pruning. Both give the same result.
+enum class Scoring { PRUNED, SPARSE };
+
+/// One language of a scored candidate: primary keyword score, and longest keyword and
+/// match count over primary + secondary keywords.
+struct LangScore {
+    double score = 0.0;
+    size_t max_len = 0;
+    size_t count = 0;
+};
+
+/// Match criteria of the winning language. The defaults are the ones the Matcher
+/// applies; its pruning (pass_floor, signatures) is derived from them, so other
+/// values are only meant for replaying recorded scores (see select_best()).
+struct PassCriteria {
+    size_t multi_count = 2;    // matches needed for the multi-keyword rule
+    double multi_score = 0.3;
+    size_t multi_len = 6;
+    double single_score = 0.5; // otherwise
+    size_t single_len = 10;
+
+    bool passes(const LangScore& s) const {
+        if (s.count >= multi_count) return s.score >= multi_score && s.max_len >= multi_len;
+        return s.score >= single_score && s.max_len >= single_len;
+    }
+};
+
+/// Unpruned scores of one candidate item in all three languages.
+struct CandidateScore {
+    uint32_t item = 0;
+    LangScore lang[3];
+
+    /// The language the matcher judges the item by: highest score, first on ties.
+    const LangScore& best() const {
+        int b = 0;
+        for (int l = 1; l < 3; ++l)
+            if (lang[l].score > lang[b].score) b = l;
+        return lang[b];
+    }
+};
+
+/// Order in which candidates win: higher score, then longer keyword, then lower item.
+inline bool ranks_before(const CandidateScore& a, const CandidateScore& b) {
+    const LangScore& x = a.best();
+    const LangScore& y = b.best();
+    if (x.score != y.score) return x.score > y.score;
+    if (x.max_len != y.max_len) return x.max_len > y.max_len;
+    return a.item < b.item;
+}
+
+/// Replay the matcher's choice over candidates ordered by ranks_before(): the first
+/// one whose best language passes wins. With the default criteria and every candidate
+/// present this is the Matcher's result. Returns nullptr if none passes.
+inline const CandidateScore* select_best(std::span<const CandidateScore> ranked,
+                                         const PassCriteria& criteria = {}) {
+    for (const auto& c : ranked)
+        if (criteria.passes(c.best())) return &c;
+    return nullptr;
+}
+
+/// Matches devices against one catalog. Each language's keywords are scored ONLY
+/// against the same language's product description.
+/// Not thread-safe: every worker owns one Matcher. Catalog-sized state (token marks,
+/// stamp sets) persists across devices; per-device temporaries live in a ScratchArena
+/// that is reset after each device, so matching does not allocate once warmed up.
+class Matcher {
+public:
+    Matcher(const std::vector<MigelItem>& migel_items, const CompiledCatalog& catalog,
+            const KeywordIndex& keyword_index)
+        : items_(migel_items), catalog_(catalog), index_(keyword_index),
+          token_match_(catalog.token_len.size(), 0) {}
+
+    bool uses(const std::vector<MigelItem>& migel_items, const CompiledCatalog& catalog,
+              const KeywordIndex& keyword_index) const {
+        return &items_ == &migel_items && &catalog_ == &catalog && &index_ == &keyword_index;
+    }
+
+    /// Choose how inflected words match keywords (TRUNCATION by default).
+    void set_morphology(Morphology morphology) { morphology_ = morphology; }
+
+    void set_scoring(Scoring scoring) { scoring_ = scoring; }
+
+    /// Also count the parts of German compound words as DE keyword hits (see
+    /// Decompounder). Off by default: it changes the scores.
+    void set_decompounding(bool on) {
+        decompounder_ = on ? std::make_unique<Decompounder>(catalog_) : nullptr;
+    }
+
+    /// Choose the candidate prefilter (SUBSTRING by default). min_overlap (0..1] is
+    /// the share of a keyword's trigrams a word must contain under TRIGRAM; it is
+    /// capped so that exact and fuzzy keyword matches always qualify.
+    void set_prefilter(Prefilter prefilter, double min_overlap = 1.0) {
+        prefilter_ = prefilter;
+        if (prefilter != Prefilter::TRIGRAM) return;
+        const TrigramIndex& tri = index_.trigrams;
+        trigrams_needed_.resize(tri.trigrams.size());
+        for (size_t k = 0; k < tri.trigrams.size(); ++k) {
+            auto share = static_cast<uint32_t>(std::ceil(min_overlap * tri.trigrams[k] - 1e-9));
+            trigrams_needed_[k] = std::clamp<uint32_t>(share, 1, tri.fuzzy_trigrams[k]);
+        }
+    }
+
+    MatchOutcome match(const DeviceText& device) {
+        MatchOutcome out = match_device(device);
+        arena_.reset();
+        return out;
+    }
+
+    /// Match devices[i] into out[i] (out.size() >= devices.size()). The next device's
+    /// text is prefetched while the current one is scored.
+    void match_batch(std::span<const DeviceText> devices, std::span<MatchOutcome> out) {
+        for (size_t i = 0; i < devices.size(); ++i) {
+            if (i + 1 < devices.size()) prefetch(devices[i + 1]);
+            out[i] = match(devices[i]);
+        }
+    }
+
+    /// Score every candidate without pruning and keep the top k by ranks_before() in
+    /// top (replacing its contents). Candidates without any matched primary keyword
+    /// cannot pass and are left out. For offline tuning of PassCriteria.
+    void score_top_k(const DeviceText& device, size_t k, std::vector<CandidateScore>& top) {
+        score_candidates(device, k, top);
+        arena_.reset();
+    }
+
+private:
+    static void prefetch(const DeviceText& d) {
+#if defined(__GNUC__)
+        for (std::string_view v : {d.desc_de, d.desc_fr, d.desc_it, d.brand})
+            if (!v.empty()) __builtin_prefetch(v.data());
+#else
+        (void)d;
+#endif
+    }
+
+    using LangIds = const std::pmr::vector<uint32_t>* [3]; // matched token ids per language
+
+    /// One normalized language channel of a device: "<desc> <brand>".
+    struct Channel {
+        std::string_view text;
+        std::span<const std::string_view> words;
+    };
+    using Channels = Channel[3];
+
+    MatchOutcome match_device(const DeviceText& device);
+    MatchOutcome match_sparse(const DeviceText& device);
+    template <class F>
+    void for_each_trigram_keyword(uint32_t lang, std::span<const std::string_view> words, F&& f);
+    void score_candidates(const DeviceText& device, size_t k, std::vector<CandidateScore>& top);
+
+    /// Shared front half of matching: normalize the device, mark its matched keywords
+    /// in token_match_ and call f(channels, lang_ids, device_weight, device_sig). Marks
+    /// are cleared afterwards.
+    template <class F>
+    void with_matches(const DeviceText& device, F&& f);
+
+    /// with_matches() that also collects the prefilter's candidates in ascending item
+    /// order and calls score(candidates, langs, device_weight, device_sig); langs[i]
+    /// has bit l set (as in token_match_) if language l's channel produced candidate i.
+    /// Other languages of a candidate have no matched primary keyword.
+    template <class F>
+    void with_candidates(const DeviceText& device, F&& score);
+
+    const std::vector<MigelItem>& items_;
+    const CompiledCatalog& catalog_;
+    const KeywordIndex& index_;
+    ScratchArena arena_;
+    std::vector<uint8_t> token_match_; // per catalog token: bit 1 DE, 2 FR, 4 IT matched
+    StampSet keyword_seen_;            // keywords of the index already expanded
+    StampSet candidate_set_;           // SPARSE: catalog items already touched
+    std::vector<uint64_t> candidate_bits_; // prefilter candidates, one bitmap per language
+    Prefilter prefilter_ = Prefilter::SUBSTRING;
+    Morphology morphology_ = Morphology::TRUNCATION;
+    Scoring scoring_ = Scoring::SPARSE;
+    std::vector<uint32_t> trigrams_needed_; // TRIGRAM: per keyword, hits that admit it
+    StampCounter trigram_hits_;             // TRIGRAM: per keyword, hits in the current word
+    size_t last_candidates_ = 0;            // candidates of the last with_candidates() call
+    std::unique_ptr<Decompounder> decompounder_; // null unless set_decompounding(true)
+    std::vector<uint64_t> sparse_mask_;     // SPARSE: per list slot, matched-keyword mask
+    std::vector<uint32_t> sparse_weight_;   // SPARSE: per list slot, matched weight
+};
+
+/// Call f(keyword_id) for every keyword of language lang reaching its trigram
+/// threshold in one of words; ids may repeat.
+template <class F>
+inline void Matcher::for_each_trigram_keyword(uint32_t lang, std::span<const std::string_view> words, F&& f) {
+    const TrigramIndex& tri = index_.trigrams;
+    std::pmr::vector<uint32_t> keys(&arena_);
+    for (std::string_view w : words) {
+        if (w.size() < 3) continue;
+        word_trigrams(w, keys);
+        trigram_hits_.reset(tri.trigrams.size());
+        for (uint32_t key : keys) {
+            uint32_t slot = tri.find(TrigramIndex::group_key(lang, key));
+            if (slot == UINT32_MAX) continue;
+            for (uint32_t kw : tri.postings(slot))
+                if (trigram_hits_.increment(kw) == trigrams_needed_[kw]) f(kw);
+        }
+    }
+}
+
+template <class F>
+inline void Matcher::with_matches(const DeviceText& device, F&& f) {
+    const auto& catalog = catalog_;
+    auto& token_match = token_match_;
+
+    // Normalize "<desc> <brand>" per language into one buffer of three channels
+    NormalizedText text(&arena_);
+    size_t word_range[4], text_range[4];
+    std::string_view descs[3] = {device.desc_de, device.desc_fr, device.desc_it};
+    for (int l = 0; l < 3; ++l) {
+        word_range[l] = text.words.size();
+        text_range[l] = text.text.size();
+        normalize_append(descs[l], text);
+        normalize_append(" ", text);
+        normalize_append(device.brand, text);
+        normalize_append(" ", text);
+    }
+    word_range[3] = text.words.size();
+    text_range[3] = text.text.size();
+    auto words_of = [&](int l) {
+        return std::span<const std::string_view>(text.words).subspan(
+            word_range[l], word_range[l + 1] - word_range[l]);
+    };
+    Channels channels;
+    for (int l = 0; l < 3; ++l)
+        channels[l] = {std::string_view(text.text).substr(text_range[l], text_range[l + 1] - text_range[l]),
+                       words_of(l)};
+
+    std::pmr::vector<uint32_t> de_ids(&arena_), fr_ids(&arena_), it_ids(&arena_);
+    if (morphology_ == Morphology::STEM) {
+        std::pmr::string key(&arena_);
+        match_stems(catalog, Lang::DE, words_of(0), de_ids, key);
+        match_stems(catalog, Lang::FR, words_of(1), fr_ids, key);
+        match_stems(catalog, Lang::IT, words_of(2), it_ids, key);
+    } else {
+        match_german_suffixes(catalog, words_of(0), de_ids);
+        lookup_words(catalog, words_of(1), fr_ids);
+        lookup_words(catalog, words_of(2), it_ids);
+    }
+    if (decompounder_) {
+        // Parts are substrings of the text, so their items are candidates already
+        for (std::string_view w : words_of(0))
+            for (uint32_t id : decompounder_->split(w)) de_ids.push_back(id);
+        std::sort(de_ids.begin(), de_ids.end());
+        de_ids.erase(std::unique(de_ids.begin(), de_ids.end()), de_ids.end());
+    }
+
+    const std::pmr::vector<uint32_t>* lang_ids[3] = {&de_ids, &fr_ids, &it_ids};
+    uint32_t device_weight[3] = {0, 0, 0}; // no item can match more weight per language
+    uint64_t device_sig[3] = {0, 0, 0};
+    for (int l = 0; l < 3; ++l) {
+        for (uint32_t id : *lang_ids[l]) {
+            token_match[id] |= static_cast<uint8_t>(1u << l);
+            device_weight[l] += catalog.token_len[id];
+            device_sig[l] |= token_bit(id);
+        }
+    }
+
+    f(channels, lang_ids, device_weight, device_sig);
+
+    for (int l = 0; l < 3; ++l)
+        for (uint32_t id : *lang_ids[l]) token_match[id] = 0;
+}
+
+template <class F>
+inline void Matcher::with_candidates(const DeviceText& device, F&& score) {
+    const auto& migel_items = items_;
+    const auto& catalog = catalog_;
+    const auto& keyword_index = index_;
+
+    with_matches(device, [&](const Channels& channels, const LangIds& lang_ids,
+                             const uint32_t (&device_weight)[3], const uint64_t (&device_sig)[3]) {
+        // Step 1: Find candidate items via each language's keyword index, probed with
+        // that language's channel only (SUBSTRING: one automaton pass, same set as
+        // fuzzy_contains() over the language's keywords; TRIGRAM: see set_prefilter())
+        size_t words = (migel_items.size() + 63) / 64;
+        candidate_bits_.assign(3 * words, 0);
+        keyword_seen_.reset(keyword_index.size());
+        for (uint32_t l = 0; l < 3; ++l) {
+            std::span<uint64_t> bits(candidate_bits_.data() + l * words, words);
+            auto add_keyword = [&](uint32_t kw) {
+                if (keyword_seen_.insert(kw)) keyword_index.add_postings(kw, bits);
+            };
+            if (morphology_ == Morphology::STEM) {
+                // Every item that can pass has a matched primary keyword
+                for (uint32_t id : *lang_ids[l]) {
+                    size_t c = catalog.column(static_cast<KeywordList>(KW_DE + l), id);
+                    for (uint32_t k = catalog.column_begin[c]; k < catalog.column_begin[c + 1]; ++k)
+                        bits[catalog.column_items[k] / 64] |= 1ULL << (catalog.column_items[k] % 64);
+                }
+            } else if (prefilter_ == Prefilter::TRIGRAM) {
+                for_each_trigram_keyword(l, channels[l].words, add_keyword);
+            } else {
+                keyword_index.automaton.for_each_match(l, channels[l].text, add_keyword);
+            }
+        }
+        // The bitmaps yield the candidates in ascending item order
+        std::pmr::vector<uint32_t> candidates(&arena_);
+        std::pmr::vector<uint8_t> langs(&arena_);
+        const uint64_t* de = candidate_bits_.data();
+        const uint64_t* fr = de + words;
+        const uint64_t* it = fr + words;
+        for (size_t w = 0; w < words; ++w) {
+            for (uint64_t bits = de[w] | fr[w] | it[w]; bits; bits &= bits - 1) {
+                int b = std::countr_zero(bits);
+                candidates.push_back(static_cast<uint32_t>(w * 64 + b));
+                langs.push_back(static_cast<uint8_t>((de[w] >> b & 1) | (fr[w] >> b & 1) << 1 | (it[w] >> b & 1) << 2));
+            }
+        }
+        last_candidates_ = candidates.size();
+
+        score(std::span<const uint32_t>(candidates), std::span<const uint8_t>(langs), device_weight, device_sig);
+    });
+}
+
+inline MatchOutcome Matcher::match_device(const DeviceText& device) {
+    if (scoring_ == Scoring::SPARSE) return match_sparse(device);
+    const auto& migel_items = items_;
+    const auto& catalog = catalog_;
+    const auto& token_match = token_match_;
+    constexpr PassCriteria criteria;
 
-    // Step 2: Score each candidate using word-level matching
     const MigelItem* best_item = nullptr;
     double best_score = 0.0;
     size_t best_max_len = 0;
 
-    for (size_t idx : candidates) {
-        const auto& item = migel_items[idx];
-
-        auto [score_de, max_len_de, count_de] = keyword_score(de_words, item.keywords_de, true, true);
-        auto [score_fr, max_len_fr, count_fr] = keyword_score(fr_words, item.keywords_fr, false, false);
-        auto [score_it, max_len_it, count_it] = keyword_score(it_words, item.keywords_it, false, false);
-
-        // Secondary bonus matches (only if at least 1 primary matched)
-        auto [s_score_de, sec_max_de, sec_count_de] = count_de > 0
-            ? keyword_score(de_words, item.secondary_de, true, true)
-            : KeywordScore{0.0, 0, 0};
-        auto [s_score_fr, sec_max_fr, sec_count_fr] = count_fr > 0
-            ? keyword_score(fr_words, item.secondary_fr, false, false)
-            : KeywordScore{0.0, 0, 0};
-        auto [s_score_it, sec_max_it, sec_count_it] = count_it > 0
-            ? keyword_score(it_words, item.secondary_it, false, false)
-            : KeywordScore{0.0, 0, 0};
-
-        size_t total_de = count_de + sec_count_de;
-        size_t total_fr = count_fr + sec_count_fr;
-        size_t total_it = count_it + sec_count_it;
-        size_t max_de = std::max(max_len_de, sec_max_de);
-        size_t max_fr = std::max(max_len_fr, sec_max_fr);
-        size_t max_it = std::max(max_len_it, sec_max_it);
-
-        // Pick best-scoring language
-        struct LangScore { double score; size_t max_len; size_t count; };
-        LangScore langs[3] = {
-            {score_de, max_de, total_de},
-            {score_fr, max_fr, total_fr},
-            {score_it, max_it, total_it},
-        };
+    // Step 2: Score each candidate using word-level matching
+    with_candidates(device, [&](std::span<const uint32_t> candidates, std::span<const uint8_t> langs,
+                                const uint32_t (&device_weight)[3], const uint64_t (&device_sig)[3]) {
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            size_t idx = candidates[i];
+            // Signature check: if every candidate language certainly fails, so does the best one
+            const KeywordSignature* sigs = &catalog.signatures[idx * 3];
+            bool can_pass = false;
+            for (int l = 0; l < 3 && !can_pass; ++l)
+                can_pass = (langs[i] >> l & 1) && signature_can_pass(sigs[l], device_sig[l]);
+            if (!can_pass) continue;
+
+            // A language can only make this item the new best with score >= bar; any
+            // language whose upper bound stays below bar cannot be the winning language.
+            double bar = std::max(0.3, best_score);
+
+            // Upper bound per language before touching any keyword: matched weight is at
+            // most the device's matched weight in that language (and 0 if the language did
+            // not make the item a candidate). Skip the item unless some language can reach
+            // both bar and its precomputed pass floor.
+            double upper[3] = {0.0, 0.0, 0.0};
+            bool reachable = false;
+            for (int l = 0; l < 3; ++l) {
+                if (!(langs[i] >> l & 1)) continue;
+                uint32_t total = catalog.list_total[catalog.slot(idx, static_cast<KeywordList>(KW_DE + l))];
+                upper[l] = total ? static_cast<double>(std::min(device_weight[l], total)) / total : 0.0;
+                if (upper[l] >= bar && upper[l] >= catalog.pass_floor[idx * 3 + l]) reachable = true;
+            }
+            if (!reachable) continue;
+
+            // Score live languages, rarest keyword first, dropping those that fall below bar
+            LangScore langs[3];
+            bool live[3];
+            for (int l = 0; l < 3; ++l) {
+                uint8_t bit = static_cast<uint8_t>(1u << l);
+                KeywordScore prim{0.0, 0, 0};
+                live[l] = upper[l] >= bar &&
+                    keyword_score_bounded(catalog, idx, static_cast<KeywordList>(KW_DE + l),
+                                          token_match, bit, bar, prim);
+                if (!live[l]) continue;
+
+                // Secondary bonus matches (only if at least 1 primary matched)
+                KeywordScore sec = prim.matched_count > 0
+                    ? keyword_score(catalog, idx, static_cast<KeywordList>(SEC_DE + l), token_match, bit)
+                    : KeywordScore{0.0, 0, 0};
+                langs[l] = {prim.score, std::max(prim.max_matched_len, sec.max_matched_len),
+                            prim.matched_count + sec.matched_count};
+            }
 
-        LangScore best_lang = langs[0];
-        for (int l = 1; l < 3; ++l) {
-            if (langs[l].score > best_lang.score) best_lang = langs[l];
+            // Pick best-scoring language (dropped languages score below any live one >= bar)
+            int best_l = -1;
+            for (int l = 0; l < 3; ++l) {
+                if (live[l] && (best_l < 0 || langs[l].score > langs[best_l].score)) best_l = l;
+            }
+            if (best_l < 0) continue;
+            const LangScore& best_lang = langs[best_l];
+
+            // Match criteria
+            if (criteria.passes(best_lang)) {
+                if (best_lang.score > best_score ||
+                    (best_lang.score == best_score && best_lang.max_len > best_max_len)) {
+                    best_score = best_lang.score;
+                    best_max_len = best_lang.max_len;
+                    best_item = &migel_items[idx];
+                }
+            }
         }
+    });
+
+    return {best_item, best_score, best_max_len, last_candidates_};
+}
+
+inline MatchOutcome Matcher::match_sparse(const DeviceText& device) {
+    const auto& migel_items = items_;
+    const auto& catalog = catalog_;
+    constexpr PassCriteria criteria;
+
+    const MigelItem* best_item = nullptr;
+    double best_score = 0.0;
+    size_t best_max_len = 0;
 
-        // Match criteria
-        bool passes = false;
-        if (best_lang.count >= 2) {
-            passes = best_lang.score >= 0.3 && best_lang.max_len >= 6;
+    with_matches(device, [&](const Channels&, const LangIds& lang_ids, const uint32_t (&)[3],
+                             const uint64_t (&)[3]) {
+        if (sparse_mask_.size() < migel_items.size() * KW_LIST_COUNT) {
+            sparse_mask_.resize(migel_items.size() * KW_LIST_COUNT);
+            sparse_weight_.resize(migel_items.size() * KW_LIST_COUNT);
+        }
+        // Primary lists first: they decide which items are scored at all (an item can
+        // only pass with a matched primary keyword).
+        std::pmr::vector<uint32_t> touched(&arena_);
+        candidate_set_.reset(migel_items.size());
+        for (bool primary : {true, false}) {
+            for (int l = 0; l < 3; ++l) {
+                auto list = static_cast<KeywordList>((primary ? KW_DE : SEC_DE) + l);
+                for (uint32_t id : *lang_ids[l]) {
+                    uint32_t len = catalog.token_len[id];
+                    size_t c = catalog.column(list, id);
+                    for (uint32_t k = catalog.column_begin[c]; k < catalog.column_begin[c + 1]; ++k) {
+                        uint32_t idx = catalog.column_items[k];
+                        if (primary) {
+                            if (candidate_set_.insert(idx)) {
+                                touched.push_back(idx);
+                                std::fill_n(&sparse_mask_[catalog.slot(idx, KW_DE)], KW_LIST_COUNT, 0);
+                                std::fill_n(&sparse_weight_[catalog.slot(idx, KW_DE)], KW_LIST_COUNT, 0);
+                            }
+                        } else if (!candidate_set_.contains(idx)) {
+                            continue;
+                        }
+                        size_t slot = catalog.slot(idx, list);
+                        sparse_mask_[slot] |= 1ULL << catalog.column_bits[k];
+                        sparse_weight_[slot] += len;
+                    }
+                }
+            }
+        }
+        // Masks with the overflow bit (long lists) are rescored from token_match_
+        auto list_score = [&](uint32_t idx, KeywordList list, uint8_t lang_bit) {
+            size_t slot = catalog.slot(idx, list);
+            uint64_t mask = sparse_mask_[slot];
+            if (mask & MASK_OVERFLOW) return keyword_score(catalog, idx, list, token_match_, lang_bit);
+            return keyword_score_mask(catalog, slot, mask, sparse_weight_[slot]);
+        };
+        last_candidates_ = touched.size();
+        if (touched.size() > migel_items.size() / 16) {
+            touched.clear();
+            for (size_t idx = 0; idx < migel_items.size(); ++idx)
+                if (candidate_set_.contains(idx)) touched.push_back(static_cast<uint32_t>(idx));
         } else {
-            passes = best_lang.score >= 0.5 && best_lang.max_len >= 10;
+            std::sort(touched.begin(), touched.end());
         }
 
-        if (passes) {
-            if (best_lang.score > best_score ||
-                (best_lang.score == best_score && best_lang.max_len > best_max_len)) {
+        for (uint32_t idx : touched) {
+            // Best language by score alone; it can only win with score >= bar, so
+            // counts and longest keywords are read for that language only
+            int best_l = -1;
+            double lang_score = 0.0;
+            for (int l = 0; l < 3; ++l) {
+                size_t prim = catalog.slot(idx, static_cast<KeywordList>(KW_DE + l));
+                if (sparse_mask_[prim] == 0) continue;
+                double score = static_cast<double>(sparse_weight_[prim]) / static_cast<double>(catalog.list_total[prim]);
+                if (best_l < 0 || score > lang_score) {
+                    best_l = l;
+                    lang_score = score;
+                }
+            }
+            if (best_l < 0 || lang_score < std::max(0.3, best_score)) continue;
+            auto bit = static_cast<uint8_t>(1u << best_l);
+            KeywordScore prim = list_score(idx, static_cast<KeywordList>(KW_DE + best_l), bit);
+            KeywordScore sec = list_score(idx, static_cast<KeywordList>(SEC_DE + best_l), bit);
+            LangScore best_lang{prim.score, std::max(prim.max_matched_len, sec.max_matched_len),
+                                prim.matched_count + sec.matched_count};
+            if (criteria.passes(best_lang) &&
+                (best_lang.score > best_score ||
+                 (best_lang.score == best_score && best_lang.max_len > best_max_len))) {
                 best_score = best_lang.score;
                 best_max_len = best_lang.max_len;
-                best_item = &item;
+                best_item = &migel_items[idx];
             }
         }
-    }
+    });
+
+    return {best_item, best_score, best_max_len, last_candidates_};
+}
+
+inline void Matcher::score_candidates(const DeviceText& device, size_t k, std::vector<CandidateScore>& top) {
+    const auto& catalog = catalog_;
+    const auto& token_match = token_match_;
+    top.clear();
+    with_candidates(device, [&](std::span<const uint32_t> candidates, std::span<const uint8_t> langs,
+                                const uint32_t (&)[3], const uint64_t (&)[3]) {
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            CandidateScore c;
+            c.item = candidates[i];
+            uint32_t idx = c.item;
+            bool any = false;
+            for (int l = 0; l < 3; ++l) {
+                uint8_t bit = static_cast<uint8_t>(1u << l);
+                if (!(langs[i] & bit)) continue;
+                KeywordScore prim = keyword_score(catalog, idx, static_cast<KeywordList>(KW_DE + l), token_match, bit);
+                if (prim.matched_count == 0) continue;
+                KeywordScore sec = keyword_score(catalog, idx, static_cast<KeywordList>(SEC_DE + l), token_match, bit);
+                c.lang[l] = {prim.score, std::max(prim.max_matched_len, sec.max_matched_len),
+                             prim.matched_count + sec.matched_count};
+                any = true;
+            }
+            if (any) top.push_back(c);
+        }
+    });
+    size_t keep = std::min(k, top.size());
+    std::partial_sort(top.begin(), top.begin() + static_cast<std::ptrdiff_t>(keep), top.end(), ranks_before);
+    top.resize(keep);
+}
 
-    return best_item;
+/// Find the best-matching MiGeL item for a product (single-device convenience wrapper;
+/// keeps one Matcher per thread).
+inline const MigelItem* find_best_migel_match(
+    const std::string& desc_de,
+    const std::string& desc_fr,
+    const std::string& desc_it,
+    const std::string& brand,
+    const std::vector<MigelItem>& migel_items,
+    const CompiledCatalog& catalog,
+    const KeywordIndex& keyword_index)
+{
+    thread_local std::unique_ptr<Matcher> matcher;
+    if (!matcher || !matcher->uses(migel_items, catalog, keyword_index))
+        matcher = std::make_unique<Matcher>(migel_items, catalog, keyword_index);
+    return matcher->match({desc_de, desc_fr, desc_it, brand}).item;
 }
 
 } // namespace migel
@@ -0,0 +1,140 @@
+// migel_bench.cpp — Compare MiGeL candidate prefilters (substring vs trigram)
+// Build: g++ -std=c++20 -O2 -pthread cpp/migel_bench.cpp -lsqlite3 -o migel_bench
+// Usage: ./migel_bench --db db/eudamed_devices.db --migel-de xlsx/migel_0.csv
+//          --migel-fr xlsx/migel_1.csv --migel-it xlsx/migel_2.csv [--overlap 1.0 ...] [--limit N]
+//
+// Routes tradeName / Description / CND_Description of every device by language (as
+// eudamed_migel does, without the English term expansion) and matches them with each
+// prefilter, reporting candidate-set size, matcher time and result differences. The
+// "sparse" row is the default column scorer, which needs no prefilter; its candidates
+// are the items with a matched primary keyword.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <sqlite3.h>
+#include "migel.hpp"
+
+struct Device {
+    std::string desc_de, desc_fr, desc_it, brand;
+};
+
+static std::vector<Device> load_devices(const std::string& path, size_t limit) {
+    std::vector<Device> devices;
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        std::cerr << "Error opening " << path << ": " << sqlite3_errmsg(db) << "\n";
+        sqlite3_close(db);
+        return devices;
+    }
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql = "SELECT tradeName, Description, CND_Description, manufacturerName FROM devices";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Error reading devices: " << sqlite3_errmsg(db) << "\n";
+        sqlite3_close(db);
+        return devices;
+    }
+    migel::NormalizedText scratch;
+    auto append = [](std::string& desc, const std::string& text) {
+        if (!desc.empty()) desc += ' ';
+        desc += text;
+    };
+    while (sqlite3_step(stmt) == SQLITE_ROW && devices.size() < limit) {
+        Device d;
+        for (int c = 0; c < 3; ++c) {
+            const char* t = reinterpret_cast<const char*>(sqlite3_column_text(stmt, c));
+            std::string field = t ? t : "";
+            if (field.empty()) continue;
+            switch (migel::detect_language(field, scratch).lang) {
+                case migel::Lang::DE: append(d.desc_de, field); break;
+                case migel::Lang::FR: append(d.desc_fr, field); break;
+                case migel::Lang::IT: append(d.desc_it, field); break;
+                case migel::Lang::EN:
+                    append(d.desc_de, field);
+                    append(d.desc_fr, field);
+                    append(d.desc_it, field);
+                    break;
+                case migel::Lang::UNKNOWN: break;
+            }
+        }
+        if (d.desc_de.empty() && d.desc_fr.empty() && d.desc_it.empty()) continue;
+        const char* b = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+        d.brand = b ? b : "";
+        devices.push_back(std::move(d));
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return devices;
+}
+
+int main(int argc, char* argv[]) {
+    std::string db, csv_de, csv_fr, csv_it;
+    std::vector<double> overlaps;
+    size_t limit = SIZE_MAX;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--db" && i + 1 < argc) db = argv[++i];
+        else if (arg == "--migel-de" && i + 1 < argc) csv_de = argv[++i];
+        else if (arg == "--migel-fr" && i + 1 < argc) csv_fr = argv[++i];
+        else if (arg == "--migel-it" && i + 1 < argc) csv_it = argv[++i];
+        else if (arg == "--overlap" && i + 1 < argc) overlaps.push_back(std::stod(argv[++i]));
+        else if (arg == "--limit" && i + 1 < argc) limit = std::stoul(argv[++i]);
+        else if (arg == "-h" || arg == "--help") {
+            std::cout << "Usage: " << argv[0]
+                      << " --db <db> --migel-de <csv> [--migel-fr <csv>] [--migel-it <csv>]"
+                      << " [--overlap X ...] [--limit N]\n"
+                      << "\nX = minimum share of a keyword's trigrams (default 1.0).\n";
+            return 0;
+        }
+    }
+    if (db.empty() || csv_de.empty()) {
+        std::cerr << "Error: --db and --migel-de are required.\nRun with --help for usage.\n";
+        return 1;
+    }
+    if (overlaps.empty()) overlaps.push_back(1.0);
+
+    migel::TokenDict tokens;
+    auto items = migel::parse_migel_items(tokens, csv_de, csv_fr, csv_it);
+    auto catalog = migel::compile_catalog(items, tokens);
+    auto index = migel::build_keyword_index(items);
+    auto devices = load_devices(db, limit);
+    std::cout << items.size() << " MiGeL items, " << index.size() << " keywords, "
+              << devices.size() << " devices with supported-language text.\n\n";
+
+    std::vector<migel::DeviceText> texts;
+    for (const auto& d : devices) texts.push_back({d.desc_de, d.desc_fr, d.desc_it, d.brand});
+
+    struct Config { std::string name; migel::Scoring scoring; migel::Prefilter prefilter; double overlap; };
+    std::vector<Config> configs = {{"substring", migel::Scoring::PRUNED, migel::Prefilter::SUBSTRING, 1.0}};
+    for (double o : overlaps)
+        configs.push_back({"trigram " + std::to_string(o).substr(0, 4), migel::Scoring::PRUNED,
+                           migel::Prefilter::TRIGRAM, o});
+    configs.push_back({"sparse", migel::Scoring::SPARSE, migel::Prefilter::SUBSTRING, 1.0});
+
+    std::vector<migel::MatchOutcome> baseline;
+    std::printf("%-14s %12s %12s %10s %10s %8s\n", "prefilter", "mean cands", "max cands", "time ms",
+                "us/device", "diffs");
+    for (const auto& c : configs) {
+        migel::Matcher matcher(items, catalog, index);
+        matcher.set_scoring(c.scoring);
+        matcher.set_prefilter(c.prefilter, c.overlap);
+        std::vector<migel::MatchOutcome> out(texts.size());
+        auto t0 = std::chrono::steady_clock::now();
+        matcher.match_batch(texts, out);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        size_t total = 0, max = 0, diffs = 0;
+        for (size_t i = 0; i < out.size(); ++i) {
+            total += out[i].candidates;
+            max = std::max(max, out[i].candidates);
+            if (!baseline.empty() && out[i].item != baseline[i].item) ++diffs;
+        }
+        if (baseline.empty()) baseline = out;
+        double n = static_cast<double>(std::max<size_t>(out.size(), 1));
+        std::printf("%-14s %12.1f %12zu %10.1f %10.2f %8zu\n", c.name.c_str(), static_cast<double>(total) / n,
+                    max, ms, ms * 1000.0 / n, diffs);
+    }
+    return 0;
+}
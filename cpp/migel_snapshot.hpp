@@ -0,0 +1,444 @@
+// migel_snapshot.hpp — Memory-mappable binary snapshot of a compiled MiGeL catalog
+// Stores the item texts, the CompiledCatalog and the KeywordIndex of migel.hpp in one
+// versioned file that is written once and then mmap'ed read-only (POSIX). The arrays
+// are used in place from the mapping, so several matcher processes on one host share
+// the same pages, and loading costs one pass over the item texts and token table.
+#pragma once
+
+#include "migel.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace migel {
+
+// ------------------------------ Catalog --------------------------------------
+
+/// Read-only mapping of a whole file; unmapped on destruction.
+struct MappedFile {
+    const char* data = nullptr;
+    size_t size = 0;
+
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() {
+        if (data) munmap(const_cast<char*>(data), size);
+    }
+};
+
+/// Everything the matcher needs: items, compiled catalog and keyword index. When
+/// opened from a snapshot, catalog and index view the mapping (declared first so it
+/// is released last), and items carry only position_nr, bezeichnung and limitation.
+struct MigelCatalog {
+    std::unique_ptr<MappedFile> mapping;
+    std::vector<MigelItem> items;
+    CompiledCatalog catalog;
+    KeywordIndex index;
+};
+
+/// Compile parsed items and their TokenDict. The keyword index is built on a second
+/// thread while the catalog is compiled.
+inline MigelCatalog build_catalog(std::vector<MigelItem> items, const TokenDict& tokens) {
+    MigelCatalog mc;
+    mc.items = std::move(items);
+    std::thread indexer([&mc] { mc.index = build_keyword_index(mc.items); });
+    mc.catalog = compile_catalog(mc.items, tokens);
+    indexer.join();
+    return mc;
+}
+
+/// Parse the MiGeL CSVs and compile them (see parse_migel_items()).
+inline MigelCatalog build_catalog(const std::string& csv_de, const std::string& csv_fr = "",
+                                  const std::string& csv_it = "") {
+    TokenDict tokens;
+    auto items = parse_migel_items(tokens, csv_de, csv_fr, csv_it);
+    return build_catalog(std::move(items), tokens);
+}
+
+/// FNV-1a checksum of the source files; a snapshot is only used if it was written from
+/// files with the same checksum. Missing files ("" or unreadable) hash as absent.
+inline uint64_t source_checksum(const std::vector<std::string>& paths) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    auto mix = [&](const char* p, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            h ^= static_cast<unsigned char>(p[i]);
+            h *= 0x100000001b3ULL;
+        }
+    };
+    std::vector<char> buf(1 << 16);
+    for (const auto& path : paths) {
+        std::ifstream f(path, std::ios::binary);
+        uint64_t size = 0;
+        while (f) {
+            f.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+            mix(buf.data(), static_cast<size_t>(f.gcount()));
+            size += static_cast<uint64_t>(f.gcount());
+        }
+        mix(reinterpret_cast<const char*>(&size), sizeof(size)); // separates the files
+    }
+    return h;
+}
+
+// ------------------------------ Snapshot format ------------------------------
+
+namespace snapshot {
+
+constexpr char MAGIC[8] = {'M', 'I', 'G', 'E', 'L', 'S', 'N', 'P'};
+constexpr uint32_t VERSION = 10;
+constexpr size_t ALIGN = 64;
+
+/// Host layout the raw arrays were written with; a snapshot is not portable across it.
+constexpr uint32_t layout_tag() {
+    return static_cast<uint32_t>(sizeof(KeywordSignature)) << 16 |
+           static_cast<uint32_t>(sizeof(double)) << 8 |
+           (std::endian::native == std::endian::little ? 1u : 2u);
+}
+
+/// Arrays of the snapshot, in file order.
+enum Section : uint32_t {
+    ITEM_TEXT,        // char: position_nr, bezeichnung, limitation of every item
+    ITEM_TEXT_BEGIN,  // uint32: item * 3 + field -> offset into ITEM_TEXT (+1 sentinel)
+    ARENA,
+    TOKEN_OFFSET,
+    TOKEN_LEN,
+    LIST_BEGIN,
+    LIST_IDS,
+    LIST_TOTAL,
+    LIST_MAX_LEN,
+    TOKEN_DF,
+    PASS_FLOOR,
+    SIGNATURES,
+    SUFFIX_NEXT,
+    SUFFIX_OUT_BEGIN,
+    SUFFIX_OUT_IDS,
+    POSTING_BEGIN,
+    POSTING_ITEMS,    // ItemId
+    POSTING_BITMAP,
+    BITMAPS,          // uint64
+    AC_NEXT,
+    AC_FIRST_OUT,
+    AC_NEXT_OUT,
+    AC_OUT_BEGIN,
+    AC_OUT_IDS,
+    TRI_KEYS,
+    TRI_BEGIN,
+    TRI_KEYWORDS,
+    TRI_TRIGRAMS,
+    TRI_FUZZY_TRIGRAMS,
+    STEM_SUFFIX_NEXT,
+    STEM_SUFFIX_OUT_BEGIN,
+    STEM_SUFFIX_OUT_IDS,
+    STEM_ARENA,
+    STEM_KEY_BEGIN,
+    STEM_TOKEN_BEGIN,
+    STEM_TOKENS,
+    COLUMN_BEGIN,
+    COLUMN_ITEMS,     // ItemId
+    LIST_WEIGHT,
+    COLUMN_BITS,
+    SECTION_COUNT
+};
+
+struct Extent {
+    uint64_t offset = 0; // from the start of the file, multiple of ALIGN
+    uint64_t bytes = 0;
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t layout;
+    uint64_t source_checksum;
+    uint64_t item_count;
+    uint64_t content_checksum; // content_checksum(): header and all section bytes
+    uint32_t automaton_stride;
+    uint32_t suffix_stride;
+    uint32_t stem_suffix_stride;
+    uint32_t reserved;
+    std::array<uint8_t, 256> automaton_classes;
+    std::array<uint8_t, 256> suffix_classes;
+    std::array<uint8_t, 256> stem_suffix_classes;
+    Extent sections[SECTION_COUNT];
+};
+
+/// Typed view of one section; clears ok (and returns an empty array) if the section
+/// size is not a whole number of T, or not expected elements when one is given.
+template <class T>
+FlatArray<T> view_section(const MappedFile& file, const Extent& e, bool& ok, size_t expected = SIZE_MAX) {
+    size_t n = e.bytes / sizeof(T);
+    if (e.bytes % sizeof(T) != 0 || (expected != SIZE_MAX && n != expected)) ok = false;
+    if (!ok) return {};
+    return FlatArray<T>::view({reinterpret_cast<const T*>(file.data + e.offset), n});
+}
+
+/// Checksum of the header (with content_checksum zeroed) and the bytes of every
+/// section. Checked on open, so a truncated or corrupted snapshot whose ids would
+/// index out of bounds is rebuilt instead of used.
+inline uint64_t content_checksum(Header h, const std::span<const char> (&sections)[SECTION_COUNT]) {
+    h.content_checksum = 0;
+    uint64_t sum = text_hash({reinterpret_cast<const char*>(&h), sizeof(h)});
+    for (const auto& s : sections) sum = (sum ^ text_hash({s.data(), s.size()})) * 0x9e3779b97f4a7c15ULL;
+    return sum;
+}
+
+} // namespace snapshot
+
+/// Write mc as a snapshot to path (via a temporary file renamed into place, so readers
+/// never see a partial file). Returns false on I/O errors.
+inline bool write_snapshot(const std::string& path, const MigelCatalog& mc, uint64_t checksum) {
+    using namespace snapshot;
+
+    std::vector<char> item_text;
+    std::vector<uint32_t> item_text_begin = {0};
+    for (const auto& item : mc.items) {
+        for (const std::string* f : {&item.position_nr, &item.bezeichnung, &item.limitation}) {
+            item_text.insert(item_text.end(), f->begin(), f->end());
+            item_text_begin.push_back(static_cast<uint32_t>(item_text.size()));
+        }
+    }
+
+    const CompiledCatalog& cat = mc.catalog;
+    const KeywordIndex& idx = mc.index;
+    auto bytes_of = [](const auto& a) {
+        return std::span<const char>(reinterpret_cast<const char*>(a.data()), a.size() * sizeof(a[0]));
+    };
+    std::span<const char> sections[SECTION_COUNT] = {
+        bytes_of(item_text), bytes_of(item_text_begin),
+        bytes_of(cat.arena), bytes_of(cat.token_offset), bytes_of(cat.token_len),
+        bytes_of(cat.list_begin), bytes_of(cat.list_ids), bytes_of(cat.list_total),
+        bytes_of(cat.list_max_len), bytes_of(cat.token_df), bytes_of(cat.pass_floor),
+        bytes_of(cat.signatures),
+        bytes_of(cat.de_suffixes.next), bytes_of(cat.de_suffixes.out_begin),
+        bytes_of(cat.de_suffixes.out_ids),
+        bytes_of(idx.posting_begin), bytes_of(idx.posting_items),
+        bytes_of(idx.posting_bitmap), bytes_of(idx.bitmaps),
+        bytes_of(idx.automaton.next), bytes_of(idx.automaton.first_out),
+        bytes_of(idx.automaton.next_out), bytes_of(idx.automaton.out_begin),
+        bytes_of(idx.automaton.out_ids),
+        bytes_of(idx.trigrams.keys), bytes_of(idx.trigrams.begin), bytes_of(idx.trigrams.keywords),
+        bytes_of(idx.trigrams.trigrams), bytes_of(idx.trigrams.fuzzy_trigrams),
+        bytes_of(cat.stems.de_suffixes.next), bytes_of(cat.stems.de_suffixes.out_begin),
+        bytes_of(cat.stems.de_suffixes.out_ids),
+        bytes_of(cat.stems.arena), bytes_of(cat.stems.key_begin), bytes_of(cat.stems.token_begin),
+        bytes_of(cat.stems.tokens),
+        bytes_of(cat.column_begin), bytes_of(cat.column_items),
+        bytes_of(cat.list_weight), bytes_of(cat.column_bits),
+    };
+
+    Header h{};
+    std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+    h.version = VERSION;
+    h.layout = layout_tag();
+    h.source_checksum = checksum;
+    h.item_count = mc.items.size();
+    h.automaton_stride = idx.automaton.stride;
+    h.suffix_stride = cat.de_suffixes.stride;
+    h.automaton_classes = idx.automaton.byte_class;
+    h.suffix_classes = cat.de_suffixes.byte_class;
+    h.stem_suffix_stride = cat.stems.de_suffixes.stride;
+    h.stem_suffix_classes = cat.stems.de_suffixes.byte_class;
+    uint64_t offset = (sizeof(Header) + ALIGN - 1) / ALIGN * ALIGN;
+    for (size_t s = 0; s < SECTION_COUNT; ++s) {
+        h.sections[s] = {offset, sections[s].size()};
+        offset += (sections[s].size() + ALIGN - 1) / ALIGN * ALIGN;
+    }
+    h.content_checksum = content_checksum(h, sections);
+
+    // Unique temporary file next to path, so concurrent writers never share one
+    std::string tmp = path + ".XXXXXX";
+    int fd = mkstemp(tmp.data());
+    if (fd < 0) return false;
+    // mkstemp() creates it 0600; give it the mode a new file would get. umask() can
+    // only be read by setting it, so that is done once and restored at once.
+    static const mode_t mask = [] {
+        mode_t m = umask(0);
+        umask(m);
+        return m;
+    }();
+    fchmod(fd, 0666 & ~mask);
+    ::close(fd);
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::remove(tmp.c_str());
+            return false;
+        }
+        static const char zeros[ALIGN] = {};
+        uint64_t pos = 0;
+        auto put = [&](const char* p, uint64_t n, uint64_t at) {
+            out.write(zeros, static_cast<std::streamsize>(at - pos)); // padding
+            out.write(p, static_cast<std::streamsize>(n));
+            pos = at + n;
+        };
+        put(reinterpret_cast<const char*>(&h), sizeof(h), 0);
+        for (size_t s = 0; s < SECTION_COUNT; ++s)
+            put(sections[s].data(), sections[s].size(), h.sections[s].offset);
+        out.write(zeros, static_cast<std::streamsize>(offset - pos));
+        if (!out.flush()) {
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+/// Map the snapshot at path into out. Returns false (out untouched) if the file is
+/// missing, malformed, from another format version or host layout, was written from
+/// sources with a different checksum, or fails its content checksum.
+inline bool open_snapshot(const std::string& path, uint64_t checksum, MigelCatalog& out) {
+    using namespace snapshot;
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st {};
+    auto file = std::make_unique<MappedFile>();
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(Header)) {
+        void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            file->data = static_cast<const char*>(p);
+            file->size = static_cast<size_t>(st.st_size);
+        }
+    }
+    ::close(fd);
+    if (!file->data) return false;
+
+    Header h;
+    std::memcpy(&h, file->data, sizeof(h));
+    if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.version != VERSION ||
+        h.layout != layout_tag() || h.source_checksum != checksum)
+        return false;
+    std::span<const char> sections[SECTION_COUNT];
+    for (size_t s = 0; s < SECTION_COUNT; ++s) {
+        const Extent& e = h.sections[s];
+        if (e.offset % ALIGN != 0 || e.offset > file->size || e.bytes > file->size - e.offset) return false;
+        sections[s] = {file->data + e.offset, static_cast<size_t>(e.bytes)};
+    }
+    if (content_checksum(h, sections) != h.content_checksum) return false;
+
+    bool ok = true;
+    auto u32 = [&](Section s, size_t expected = SIZE_MAX) {
+        return view_section<uint32_t>(*file, h.sections[s], ok, expected);
+    };
+
+    size_t items = h.item_count;
+    MigelCatalog mc;
+    auto item_text = view_section<char>(*file, h.sections[ITEM_TEXT], ok);
+    auto item_text_begin = u32(ITEM_TEXT_BEGIN, items * 3 + 1);
+
+    CompiledCatalog& cat = mc.catalog;
+    cat.item_count = items;
+    cat.arena = view_section<char>(*file, h.sections[ARENA], ok);
+    cat.token_offset = u32(TOKEN_OFFSET);
+    cat.token_len = u32(TOKEN_LEN, cat.token_offset.size());
+    cat.list_begin = u32(LIST_BEGIN, items * KW_LIST_COUNT + 1);
+    cat.list_ids = u32(LIST_IDS);
+    cat.list_total = u32(LIST_TOTAL, items * KW_LIST_COUNT);
+    cat.list_max_len = u32(LIST_MAX_LEN, items * KW_LIST_COUNT);
+    cat.token_df = u32(TOKEN_DF, cat.token_offset.size());
+    cat.pass_floor = view_section<double>(*file, h.sections[PASS_FLOOR], ok, items * 3);
+    cat.signatures = view_section<KeywordSignature>(*file, h.sections[SIGNATURES], ok, items * 3);
+    cat.de_suffixes.byte_class = h.suffix_classes;
+    cat.de_suffixes.stride = h.suffix_stride;
+    cat.de_suffixes.next = u32(SUFFIX_NEXT);
+    cat.de_suffixes.out_begin = u32(SUFFIX_OUT_BEGIN);
+    cat.de_suffixes.out_ids = u32(SUFFIX_OUT_IDS);
+    cat.stems.de_suffixes.byte_class = h.stem_suffix_classes;
+    cat.stems.de_suffixes.stride = h.stem_suffix_stride;
+    cat.stems.de_suffixes.next = u32(STEM_SUFFIX_NEXT);
+    cat.stems.de_suffixes.out_begin = u32(STEM_SUFFIX_OUT_BEGIN);
+    cat.stems.de_suffixes.out_ids = u32(STEM_SUFFIX_OUT_IDS);
+    cat.stems.arena = view_section<char>(*file, h.sections[STEM_ARENA], ok);
+    cat.stems.key_begin = u32(STEM_KEY_BEGIN);
+    cat.stems.token_begin = u32(STEM_TOKEN_BEGIN, cat.stems.key_begin.size());
+    cat.stems.tokens = u32(STEM_TOKENS);
+    cat.column_begin = u32(COLUMN_BEGIN, KW_LIST_COUNT * cat.token_offset.size() + 1);
+    cat.column_items = view_section<ItemId>(*file, h.sections[COLUMN_ITEMS], ok, cat.list_ids.size());
+    cat.list_weight = u32(LIST_WEIGHT, cat.list_ids.size());
+    cat.column_bits = view_section<uint8_t>(*file, h.sections[COLUMN_BITS], ok, cat.list_ids.size());
+
+    KeywordIndex& idx = mc.index;
+    idx.item_count = items;
+    idx.posting_begin = u32(POSTING_BEGIN);
+    idx.posting_items = view_section<ItemId>(*file, h.sections[POSTING_ITEMS], ok);
+    idx.posting_bitmap = u32(POSTING_BITMAP, idx.size());
+    idx.bitmaps = view_section<uint64_t>(*file, h.sections[BITMAPS], ok);
+    idx.automaton.byte_class = h.automaton_classes;
+    idx.automaton.stride = h.automaton_stride;
+    idx.automaton.next = u32(AC_NEXT);
+    idx.automaton.first_out = u32(AC_FIRST_OUT);
+    idx.automaton.next_out = u32(AC_NEXT_OUT, idx.automaton.first_out.size());
+    idx.automaton.out_begin = u32(AC_OUT_BEGIN, idx.automaton.first_out.size() + 1);
+    idx.automaton.out_ids = u32(AC_OUT_IDS);
+    idx.trigrams.keys = u32(TRI_KEYS);
+    idx.trigrams.begin = u32(TRI_BEGIN, idx.trigrams.keys.size() + 1);
+    idx.trigrams.keywords = u32(TRI_KEYWORDS);
+    idx.trigrams.trigrams = view_section<uint16_t>(*file, h.sections[TRI_TRIGRAMS], ok, idx.size());
+    idx.trigrams.fuzzy_trigrams = view_section<uint16_t>(*file, h.sections[TRI_FUZZY_TRIGRAMS], ok, idx.size());
+    if (!ok || h.automaton_stride == 0 || idx.automaton.first_out.size() < 3 ||
+        idx.automaton.next.size() != idx.automaton.first_out.size() * h.automaton_stride ||
+        h.suffix_stride == 0 || cat.de_suffixes.next.size() % h.suffix_stride != 0 ||
+        (idx.bitmap_words() != 0 && idx.bitmaps.size() % idx.bitmap_words() != 0) ||
+        h.stem_suffix_stride == 0 || cat.stems.de_suffixes.next.size() % h.stem_suffix_stride != 0 ||
+        item_text_begin[items * 3] != item_text.size() || cat.token_offset.empty() != cat.arena.empty())
+        return false;
+
+    mc.items.resize(items);
+    for (size_t i = 0; i < items; ++i) {
+        auto field = [&](size_t f) {
+            size_t k = i * 3 + f;
+            return std::string(item_text.data() + item_text_begin[k], item_text_begin[k + 1] - item_text_begin[k]);
+        };
+        mc.items[i].position_nr = field(0);
+        mc.items[i].bezeichnung = field(1);
+        mc.items[i].limitation = field(2);
+    }
+    cat.index_tokens();
+    mc.mapping = std::move(file);
+    out = std::move(mc);
+    return true;
+}
+
+/// SOURCE: built from the source files (CSVs or workbook, see migel_xlsx.hpp).
+enum class CatalogSource { SOURCE, SNAPSHOT, SOURCE_SNAPSHOT_WRITTEN };
+
+/// Open the snapshot at snapshot_path if it was written from the same source files,
+/// otherwise build the catalog with build() and (re)write the snapshot. An empty
+/// snapshot_path always builds. source (optional) reports which path was taken.
+template <class Build>
+inline MigelCatalog load_catalog(const std::vector<std::string>& sources, const std::string& snapshot_path,
+                                 CatalogSource* source, Build&& build) {
+    MigelCatalog mc;
+    CatalogSource from = CatalogSource::SOURCE;
+    uint64_t checksum = snapshot_path.empty() ? 0 : source_checksum(sources);
+    if (!snapshot_path.empty() && open_snapshot(snapshot_path, checksum, mc)) {
+        from = CatalogSource::SNAPSHOT;
+    } else {
+        mc = build();
+        if (!snapshot_path.empty() && write_snapshot(snapshot_path, mc, checksum))
+            from = CatalogSource::SOURCE_SNAPSHOT_WRITTEN;
+    }
+    if (source) *source = from;
+    return mc;
+}
+
+/// load_catalog() from the MiGeL CSVs.
+inline MigelCatalog load_catalog(const std::string& csv_de, const std::string& csv_fr,
+                                 const std::string& csv_it, const std::string& snapshot_path,
+                                 CatalogSource* source = nullptr) {
+    return load_catalog({csv_de, csv_fr, csv_it}, snapshot_path, source,
+                        [&] { return build_catalog(csv_de, csv_fr, csv_it); });
+}
+
+} // namespace migel
@@ -0,0 +1,181 @@
+// migel_tune.cpp — Replay MiGeL match criteria over recorded candidate scores
+// Build: g++ -std=c++20 -O2 -pthread cpp/migel_tune.cpp -lsqlite3 -o migel_tune
+// Usage: ./migel_tune db/eudamed_migel_DD.MM.YYYY.db [--criteria 2,0.3,6,0.5,10 ...]
+//
+// Reads the migel_candidates tables written by `eudamed_migel --top-k K` and, for each
+// --criteria (multi_count,multi_score,multi_len,single_score,single_len), reports how
+// many devices would match and how the assignment differs from the default criteria.
+// Uses the same selection as the matcher (migel::select_best); the replay is exact
+// whenever a recorded candidate passes, and marks "truncated" devices whose K recorded
+// candidates all fail (a lower-ranked one might have passed).
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <sqlite3.h>
+#include "migel.hpp"
+
+// ----------------------------- Recorded scores --------------------------------
+
+struct Tuple {
+    std::vector<migel::CandidateScore> ranked; // CandidateScore::item indexes positions
+    size_t devices = 0;
+};
+
+struct Recording {
+    size_t top_k = 0;
+    std::vector<std::string> positions; // position_nr per interned item id
+    std::vector<Tuple> tuples;
+};
+
+static bool load_recording(const std::string& path, Recording& rec) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        std::cerr << "Error opening " << path << ": " << sqlite3_errmsg(db) << "\n";
+        sqlite3_close(db);
+        return false;
+    }
+    auto query = [&](const char* sql, auto&& row) {
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+            std::cerr << "Error reading " << path << ": " << sqlite3_errmsg(db)
+                      << "\n(was it written with eudamed_migel --top-k?)\n";
+            return false;
+        }
+        while (sqlite3_step(stmt) == SQLITE_ROW) row(stmt);
+        sqlite3_finalize(stmt);
+        return true;
+    };
+    auto ensure_tuple = [&](sqlite3_int64 t) -> Tuple& {
+        if (static_cast<size_t>(t) >= rec.tuples.size()) rec.tuples.resize(static_cast<size_t>(t) + 1);
+        return rec.tuples[static_cast<size_t>(t)];
+    };
+
+    std::unordered_map<std::string, uint32_t> position_ids;
+    bool ok = query("SELECT top_k FROM migel_candidates_meta", [&](sqlite3_stmt* st) {
+        rec.top_k = static_cast<size_t>(sqlite3_column_int64(st, 0));
+    });
+    ok = ok && query("SELECT tuple, migel_position_nr, score_de, max_len_de, count_de, score_fr, max_len_fr,"
+                     " count_fr, score_it, max_len_it, count_it FROM migel_candidates ORDER BY tuple, rank",
+                     [&](sqlite3_stmt* st) {
+        const char* pos = reinterpret_cast<const char*>(sqlite3_column_text(st, 1));
+        auto [it, inserted] = position_ids.try_emplace(pos ? pos : "", static_cast<uint32_t>(rec.positions.size()));
+        if (inserted) rec.positions.push_back(it->first);
+        migel::CandidateScore c;
+        c.item = it->second;
+        for (int l = 0; l < 3; ++l) {
+            c.lang[l] = {sqlite3_column_double(st, 2 + l * 3),
+                         static_cast<size_t>(sqlite3_column_int64(st, 3 + l * 3)),
+                         static_cast<size_t>(sqlite3_column_int64(st, 4 + l * 3))};
+        }
+        ensure_tuple(sqlite3_column_int64(st, 0)).ranked.push_back(c);
+    });
+    ok = ok && query("SELECT tuple, COUNT(*) FROM migel_candidate_devices GROUP BY tuple", [&](sqlite3_stmt* st) {
+        ensure_tuple(sqlite3_column_int64(st, 0)).devices = static_cast<size_t>(sqlite3_column_int64(st, 1));
+    });
+    sqlite3_close(db);
+    return ok;
+}
+
+// ----------------------------- Replay -----------------------------------------
+
+static bool parse_criteria(const std::string& spec, migel::PassCriteria& c) {
+    std::vector<std::string> parts;
+    std::stringstream ss(spec);
+    for (std::string p; std::getline(ss, p, ',');) parts.push_back(p);
+    if (parts.size() != 5) return false;
+    try {
+        c.multi_count = std::stoul(parts[0]);
+        c.multi_score = std::stod(parts[1]);
+        c.multi_len = std::stoul(parts[2]);
+        c.single_score = std::stod(parts[3]);
+        c.single_len = std::stoul(parts[4]);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+struct ReplayStats {
+    size_t matched = 0;   // devices with a passing candidate
+    size_t changed = 0;   // matched under both, to different MiGeL positions
+    size_t gained = 0;    // matched here, not under the default criteria
+    size_t lost = 0;      // matched under the default criteria, not here
+    size_t truncated = 0; // no recorded candidate passes but all K were recorded
+};
+
+/// Selected item per tuple (UINT32_MAX = none).
+static std::vector<uint32_t> replay(const Recording& rec, const migel::PassCriteria& criteria) {
+    std::vector<uint32_t> chosen(rec.tuples.size(), UINT32_MAX);
+    for (size_t t = 0; t < rec.tuples.size(); ++t)
+        if (const auto* c = migel::select_best(rec.tuples[t].ranked, criteria)) chosen[t] = c->item;
+    return chosen;
+}
+
+static ReplayStats compare(const Recording& rec, const std::vector<uint32_t>& base,
+                           const std::vector<uint32_t>& chosen) {
+    ReplayStats st;
+    for (size_t t = 0; t < rec.tuples.size(); ++t) {
+        size_t n = rec.tuples[t].devices;
+        bool now = chosen[t] != UINT32_MAX, before = base[t] != UINT32_MAX;
+        if (now) st.matched += n;
+        if (now && before && chosen[t] != base[t]) st.changed += n;
+        if (now && !before) st.gained += n;
+        if (!now && before) st.lost += n;
+        if (!now && rec.tuples[t].ranked.size() >= rec.top_k) st.truncated += n;
+    }
+    return st;
+}
+
+// ----------------------------- Main ------------------------------------------
+
+int main(int argc, char* argv[]) {
+    std::string db_path;
+    std::vector<std::string> specs;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--criteria" && i + 1 < argc) specs.push_back(argv[++i]);
+        else if (arg == "-h" || arg == "--help") {
+            std::cout << "Usage: " << argv[0] << " <eudamed_migel db> [--criteria C ...]\n"
+                      << "\nC = multi_count,multi_score,multi_len,single_score,single_len\n"
+                      << "(default 2,0.3,6,0.5,10: >= multi_count matches need score >= multi_score and\n"
+                      << "a keyword >= multi_len chars, otherwise score >= single_score and >= single_len).\n"
+                      << "The DB must have been written by eudamed_migel --top-k K.\n";
+            return 0;
+        } else db_path = arg;
+    }
+    if (db_path.empty()) {
+        std::cerr << "Error: database path required.\nRun with --help for usage.\n";
+        return 1;
+    }
+
+    Recording rec;
+    if (!load_recording(db_path, rec)) return 1;
+    size_t devices = 0;
+    for (const auto& t : rec.tuples) devices += t.devices;
+    std::cout << "Loaded " << rec.tuples.size() << " device texts (" << devices
+              << " devices), top " << rec.top_k << " candidates each.\n\n";
+
+    std::vector<migel::PassCriteria> configs = {migel::PassCriteria{}};
+    for (const auto& spec : specs) {
+        migel::PassCriteria c;
+        if (!parse_criteria(spec, c)) {
+            std::cerr << "Error: bad --criteria '" << spec << "'\n";
+            return 1;
+        }
+        configs.push_back(c);
+    }
+
+    auto base = replay(rec, configs[0]);
+    std::cout << "criteria                matched   changed    gained      lost  truncated\n";
+    for (const auto& c : configs) {
+        ReplayStats st = compare(rec, base, replay(rec, c));
+        std::string label = std::to_string(c.multi_count) + "," + std::to_string(c.multi_score).substr(0, 4) + "," +
+                            std::to_string(c.multi_len) + "," + std::to_string(c.single_score).substr(0, 4) + "," +
+                            std::to_string(c.single_len);
+        std::printf("%-22s %9zu %9zu %9zu %9zu %10zu\n", label.c_str(), st.matched, st.changed,
+                    st.gained, st.lost, st.truncated);
+    }
+    return 0;
+}
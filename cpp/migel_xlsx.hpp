@@ -0,0 +1,456 @@
+// migel_xlsx.hpp — Read the MiGeL workbook (xlsx/migel.xlsx) without ssconvert
+// Opens the XLSX zip container (central directory, stored and deflated entries via
+// zlib), scans sharedStrings.xml and the DE, FR and IT worksheets with a small pull
+// XML scanner and feeds columns H/J/K into build_migel_items() (migel.hpp), exactly as
+// parse_csv_sheet() does for the CSVs exported by ssconvert. Link with -lz.
+#pragma once
+
+#include "migel.hpp"
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <zlib.h>
+
+namespace migel {
+
+// ------------------------------ Zip archive ----------------------------------
+
+/// Read-only zip archive held in memory. Supports stored and deflated entries, which
+/// is all XLSX writers use; ZIP64 archives (> 4 GB or > 65535 entries) are rejected.
+class ZipArchive {
+public:
+    /// Read path and its central directory. Returns false (with error set) if the file
+    /// cannot be read or is not a zip archive.
+    bool open(const std::string& path) {
+        if (!read_file(path, data_)) return fail("cannot open file");
+        // End of central directory record: 22 bytes plus a comment of up to 64 KB
+        if (data_.size() < 22) return fail("not a zip archive");
+        size_t eocd = data_.size() - 22;
+        size_t stop = eocd > 0xFFFF ? eocd - 0xFFFF : 0;
+        while (u32(eocd) != 0x06054b50) {
+            if (eocd == stop) return fail("not a zip archive");
+            --eocd;
+        }
+        size_t count = u16(eocd + 10);
+        size_t pos = u32(eocd + 16);
+        if (count == 0xFFFF || pos == 0xFFFFFFFF) return fail("ZIP64 archives are not supported");
+        for (size_t i = 0; i < count; ++i) {
+            if (pos + 46 > data_.size() || u32(pos) != 0x02014b50) return fail("corrupt central directory");
+            Entry e;
+            e.method = u16(pos + 10);
+            e.crc = u32(pos + 16);
+            e.compressed = u32(pos + 20);
+            e.size = u32(pos + 24);
+            e.local_header = u32(pos + 42);
+            size_t name_len = u16(pos + 28);
+            size_t next = pos + 46 + name_len + u16(pos + 30) + u16(pos + 32);
+            if (next > data_.size()) return fail("corrupt central directory");
+            entries_.emplace(data_.substr(pos + 46, name_len), e);
+            pos = next;
+        }
+        return true;
+    }
+
+    bool contains(const std::string& name) const { return entries_.count(name) != 0; }
+
+    /// Inflate entry name into out. Returns false (with error set) if it is missing,
+    /// uses another compression method or fails its CRC check.
+    bool extract(const std::string& name, std::string& out, std::string& error) const {
+        auto it = entries_.find(name);
+        if (it == entries_.end()) return fail(error, name + ": missing");
+        const Entry& e = it->second;
+        size_t local = e.local_header;
+        if (local + 30 > data_.size() || u32(local) != 0x04034b50) return fail(error, name + ": corrupt entry");
+        size_t begin = local + 30 + u16(local + 26) + u16(local + 28);
+        if (begin + e.compressed > data_.size()) return fail(error, name + ": truncated");
+        out.resize(e.size);
+        if (e.method == 0) {
+            if (e.compressed != e.size) return fail(error, name + ": corrupt entry");
+            std::memcpy(out.data(), data_.data() + begin, e.size);
+        } else if (e.method == 8) {
+            z_stream zs{};
+            if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) return fail(error, name + ": inflate failed");
+            zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data_.data() + begin));
+            zs.avail_in = static_cast<uInt>(e.compressed);
+            zs.next_out = reinterpret_cast<Bytef*>(out.data());
+            zs.avail_out = static_cast<uInt>(out.size());
+            int rc = inflate(&zs, Z_FINISH);
+            bool complete = rc == Z_STREAM_END && zs.total_out == e.size;
+            inflateEnd(&zs);
+            if (!complete) return fail(error, name + ": inflate failed");
+        } else {
+            return fail(error, name + ": unsupported compression method " + std::to_string(e.method));
+        }
+        uLong crc = crc32(0L, reinterpret_cast<const Bytef*>(out.data()), static_cast<uInt>(out.size()));
+        if (crc != e.crc) return fail(error, name + ": CRC mismatch");
+        return true;
+    }
+
+    const std::string& error() const { return error_; }
+
+private:
+    struct Entry {
+        uint16_t method = 0;
+        uint32_t crc = 0;
+        uint32_t compressed = 0;
+        uint32_t size = 0;
+        uint32_t local_header = 0;
+    };
+
+    std::string data_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::string error_;
+
+    uint32_t u16(size_t pos) const {
+        auto b = reinterpret_cast<const unsigned char*>(data_.data() + pos);
+        return b[0] | b[1] << 8;
+    }
+    uint32_t u32(size_t pos) const {
+        auto b = reinterpret_cast<const unsigned char*>(data_.data() + pos);
+        return b[0] | b[1] << 8 | b[2] << 16 | static_cast<uint32_t>(b[3]) << 24;
+    }
+    bool fail(const char* what) {
+        error_ = what;
+        return false;
+    }
+    static bool fail(std::string& error, std::string what) {
+        error = std::move(what);
+        return false;
+    }
+};
+
+// ------------------------------ XML scanning ---------------------------------
+
+/// Pull scanner over the markup of one XML part: next() returns the tags in document
+/// order, each with the raw character data since the previous tag. Comments,
+/// processing instructions and declarations are skipped; SpreadsheetML needs no more.
+struct XmlScanner {
+    struct Tag {
+        std::string_view name;  // local name, namespace prefix stripped
+        std::string_view attrs; // raw attribute text
+        std::string_view text;  // character data before the tag (not decoded)
+        bool end = false;       // </name>
+        bool empty = false;     // <name/>
+    };
+
+    std::string_view xml;
+    size_t pos = 0;
+
+    bool next(Tag& tag) {
+        size_t text_begin = pos;
+        for (;;) {
+            size_t lt = xml.find('<', pos);
+            if (lt == std::string_view::npos || lt + 1 >= xml.size()) return false;
+            char c = xml[lt + 1];
+            if (c == '?' || c == '!') {
+                std::string_view close = xml.compare(lt, 4, "<!--") == 0 ? "-->" : ">";
+                size_t end = xml.find(close, lt + 2);
+                if (end == std::string_view::npos) return false;
+                pos = end + close.size();
+                text_begin = pos;
+                continue;
+            }
+            size_t gt = xml.find('>', lt);
+            if (gt == std::string_view::npos) return false;
+            tag.text = xml.substr(text_begin, lt - text_begin);
+            tag.end = c == '/';
+            tag.empty = !tag.end && xml[gt - 1] == '/';
+            size_t name_begin = lt + (tag.end ? 2 : 1);
+            size_t name_end = std::min(xml.find_first_of(" \t\r\n/>", name_begin), gt);
+            tag.name = local_name(xml.substr(name_begin, name_end - name_begin));
+            tag.attrs = xml.substr(name_end, gt - (tag.empty ? 1 : 0) - name_end);
+            pos = gt + 1;
+            return true;
+        }
+    }
+
+    static std::string_view local_name(std::string_view name) {
+        size_t colon = name.find(':');
+        return colon == std::string_view::npos ? name : name.substr(colon + 1);
+    }
+};
+
+/// Raw value of the attribute with local name key (namespace prefix ignored), or "".
+inline std::string_view xml_attr(std::string_view attrs, std::string_view key) {
+    size_t pos = 0;
+    while (pos < attrs.size()) {
+        size_t eq = attrs.find('=', pos);
+        if (eq == std::string_view::npos) break;
+        std::string_view name = attrs.substr(pos, eq - pos);
+        name.remove_prefix(std::min(name.find_first_not_of(" \t\r\n"), name.size()));
+        name = name.substr(0, name.find_last_not_of(" \t\r\n") + 1);
+        size_t open = attrs.find_first_of("\"'", eq);
+        if (open == std::string_view::npos) break;
+        size_t close = attrs.find(attrs[open], open + 1);
+        if (close == std::string_view::npos) break;
+        if (XmlScanner::local_name(name) == key) return attrs.substr(open + 1, close - open - 1);
+        pos = close + 1;
+    }
+    return {};
+}
+
+/// Append the UTF-8 encoding of code point cp to out.
+inline void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | cp >> 6);
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | cp >> 12);
+        out += static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | cp >> 18);
+        out += static_cast<char>(0x80 | (cp >> 12 & 0x3F));
+        out += static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+/// Append XML character data to out, decoding entity and character references and the
+/// _xHHHH_ escapes OOXML uses for control characters (e.g. _x000D_ for CR). Invalid
+/// references (out of range, surrogates) are kept as text.
+inline void append_xml_text(std::string& out, std::string_view raw) {
+    // Digits of a character reference in base 10 or 16; false unless they name a Unicode
+    // scalar value (at most 0x10FFFF, no surrogate), checked digit by digit.
+    auto code_point = [](std::string_view s, uint32_t base, uint32_t& cp) {
+        cp = 0;
+        for (char c : s) {
+            int d = c >= '0' && c <= '9' ? c - '0'
+                  : base == 16 && c >= 'a' && c <= 'f' ? c - 'a' + 10
+                  : base == 16 && c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+            if (d < 0) return false;
+            cp = cp * base + static_cast<uint32_t>(d);
+            if (cp > 0x10FFFF) return false;
+        }
+        return !s.empty() && (cp < 0xD800 || cp > 0xDFFF);
+    };
+    size_t pos = 0;
+    while (pos < raw.size()) {
+        size_t special = std::min(raw.find_first_of("&_", pos), raw.size());
+        out.append(raw.substr(pos, special - pos));
+        pos = special;
+        if (pos == raw.size()) break;
+        uint32_t cp = 0;
+        if (raw[pos] == '_') {
+            // _xHHHH_
+            if (pos + 7 <= raw.size() && raw[pos + 1] == 'x' && raw[pos + 6] == '_' &&
+                code_point(raw.substr(pos + 2, 4), 16, cp)) {
+                append_utf8(out, cp);
+                pos += 7;
+            } else {
+                out += '_';
+                ++pos;
+            }
+            continue;
+        }
+        size_t semi = raw.find(';', pos);
+        std::string_view ref = semi == std::string_view::npos ? std::string_view{} : raw.substr(pos + 1, semi - pos - 1);
+        if (ref == "amp") out += '&';
+        else if (ref == "lt") out += '<';
+        else if (ref == "gt") out += '>';
+        else if (ref == "quot") out += '"';
+        else if (ref == "apos") out += '\'';
+        else if (ref.size() > 2 && ref[0] == '#' && (ref[1] == 'x' || ref[1] == 'X') &&
+                 code_point(ref.substr(2), 16, cp))
+            append_utf8(out, cp);
+        else if (ref.size() > 1 && ref[0] == '#' && code_point(ref.substr(1), 10, cp))
+            append_utf8(out, cp);
+        else {
+            out += '&'; // not a reference: keep as is
+            ++pos;
+            continue;
+        }
+        pos = semi + 1;
+    }
+}
+
+// ------------------------------ Workbook parts -------------------------------
+
+/// Relationship targets of a .rels part by Id, resolved against base_dir.
+inline std::unordered_map<std::string, std::string> parse_relationships(std::string_view xml,
+                                                                        const std::string& base_dir,
+                                                                        std::string* shared_strings = nullptr) {
+    std::unordered_map<std::string, std::string> targets;
+    XmlScanner scan{xml};
+    XmlScanner::Tag tag;
+    while (scan.next(tag)) {
+        if (tag.end || tag.name != "Relationship") continue;
+        std::string target(xml_attr(tag.attrs, "Target"));
+        target = !target.empty() && target[0] == '/' ? target.substr(1) : base_dir + target;
+        if (shared_strings && xml_attr(tag.attrs, "Type").ends_with("/sharedStrings"))
+            *shared_strings = target;
+        targets.emplace(xml_attr(tag.attrs, "Id"), std::move(target));
+    }
+    return targets;
+}
+
+/// The shared string table: one string per <si>, the concatenation of its <t> runs
+/// (phonetic <rPh> runs left out).
+inline std::vector<std::string> parse_shared_strings(std::string_view xml) {
+    std::vector<std::string> strings;
+    XmlScanner scan{xml};
+    XmlScanner::Tag tag;
+    bool phonetic = false;
+    while (scan.next(tag)) {
+        if (tag.name == "si") {
+            if (!tag.end) strings.emplace_back();
+        } else if (tag.name == "rPh") {
+            phonetic = !tag.end && !tag.empty;
+        } else if (tag.name == "t" && tag.end && !phonetic && !strings.empty()) {
+            append_xml_text(strings.back(), tag.text);
+        }
+    }
+    return strings;
+}
+
+/// Zero-based column of a cell reference ("H12" -> 7), or -1 without column letters.
+inline int cell_column(std::string_view ref) {
+    int col = 0;
+    size_t i = 0;
+    for (; i < ref.size() && ref[i] >= 'A' && ref[i] <= 'Z'; ++i) col = col * 26 + (ref[i] - 'A' + 1);
+    return i == 0 ? -1 : col - 1;
+}
+
+/// One-based number of a row reference ("12"), or 0 if it is not a number.
+inline uint32_t row_number(std::string_view ref) {
+    uint32_t row = 0;
+    for (char c : ref) {
+        if (c < '0' || c > '9' || row > (UINT32_MAX - 9) / 10) return 0;
+        row = row * 10 + static_cast<uint32_t>(c - '0');
+    }
+    return row;
+}
+
+/// Parse one worksheet into MiGeL rows, like parse_csv_sheet(): row 1 is the header,
+/// columns H, J and K are (pos_nr, bezeichnung, limitation). Shared strings are looked
+/// up, inline strings and numbers are taken as stored. Rows are numbered by their r
+/// attribute, so a sheet that stores no row 1 loses no data row.
+inline SheetRows parse_xlsx_sheet(std::string_view xml, const std::vector<std::string>& shared) {
+    constexpr int COLUMNS[3] = {7, 9, 10}; // H, J, K
+    SheetRows rows;
+    XmlScanner scan{xml};
+    XmlScanner::Tag tag;
+    std::string fields[3], value;
+    std::string_view type;
+    uint32_t row = 0, next_row = 1;
+    bool phonetic = false;
+    int col = -1, next_col = 0;
+    while (scan.next(tag)) {
+        if (tag.name == "row") {
+            if (!tag.end) {
+                row = row_number(xml_attr(tag.attrs, "r"));
+                if (row == 0) row = next_row;
+                next_row = row + 1;
+                for (auto& f : fields) f.clear();
+                next_col = 0;
+            }
+            if ((tag.end || tag.empty) && row != 1)
+                rows.emplace_back(trim(fields[0]), trim(fields[1]), trim(fields[2]));
+        } else if (tag.name == "c") {
+            if (!tag.end) {
+                col = cell_column(xml_attr(tag.attrs, "r"));
+                if (col < 0) col = next_col;
+                next_col = col + 1;
+                type = xml_attr(tag.attrs, "t");
+                value.clear();
+            }
+            if (tag.end || tag.empty) {
+                const int* slot = std::find(std::begin(COLUMNS), std::end(COLUMNS), col);
+                if (slot == std::end(COLUMNS)) continue;
+                std::string& field = fields[slot - COLUMNS];
+                if (type == "s") {
+                    char* end = nullptr;
+                    unsigned long i = std::strtoul(value.c_str(), &end, 10);
+                    if (end != value.c_str() && i < shared.size()) field = shared[i];
+                } else if (type == "b") {
+                    field = value == "1" ? "TRUE" : "FALSE";
+                } else {
+                    field = value;
+                }
+            }
+        } else if (tag.name == "rPh") {
+            phonetic = !tag.end && !tag.empty;
+        } else if ((tag.name == "v" || tag.name == "t") && tag.end && !phonetic) {
+            append_xml_text(value, tag.text);
+        }
+    }
+    return rows;
+}
+
+// ------------------------------ Workbook -------------------------------------
+
+/// Read the first three worksheets of an XLSX workbook in workbook order (DE, FR, IT,
+/// as ssconvert numbers them migel_0..2). Sheets are scanned concurrently after the
+/// shared strings. Returns false and reports to stderr if the workbook cannot be read.
+inline bool read_xlsx_sheets(const std::string& path, std::array<SheetRows, 3>& sheets) {
+    auto fail = [&](const std::string& what) {
+        std::cerr << "Error: " << path << ": " << what << "\n";
+        return false;
+    };
+    ZipArchive zip;
+    if (!zip.open(path)) return fail(zip.error());
+
+    std::string workbook_path = "xl/workbook.xml", xml, error;
+    if (zip.contains("_rels/.rels") && zip.extract("_rels/.rels", xml, error)) {
+        XmlScanner scan{xml};
+        XmlScanner::Tag tag;
+        while (scan.next(tag))
+            if (tag.name == "Relationship" && xml_attr(tag.attrs, "Type").ends_with("/officeDocument")) {
+                std::string target(xml_attr(tag.attrs, "Target"));
+                workbook_path = !target.empty() && target[0] == '/' ? target.substr(1) : target;
+            }
+    }
+    std::string base_dir = workbook_path.substr(0, workbook_path.rfind('/') + 1);
+    std::string rels_path = base_dir + "_rels/" + workbook_path.substr(base_dir.size()) + ".rels";
+    std::string shared_path;
+    if (!zip.extract(rels_path, xml, error)) return fail(error);
+    auto targets = parse_relationships(xml, base_dir, &shared_path);
+
+    std::vector<std::string> sheet_paths;
+    if (!zip.extract(workbook_path, xml, error)) return fail(error);
+    XmlScanner scan{xml};
+    XmlScanner::Tag tag;
+    while (scan.next(tag) && sheet_paths.size() < 3) {
+        if (tag.end || tag.name != "sheet") continue;
+        auto it = targets.find(std::string(xml_attr(tag.attrs, "id")));
+        if (it == targets.end()) return fail("sheet without a worksheet part");
+        sheet_paths.push_back(it->second);
+    }
+    if (sheet_paths.empty()) return fail("no worksheets");
+
+    std::vector<std::string> shared;
+    if (!shared_path.empty()) {
+        if (!zip.extract(shared_path, xml, error)) return fail(error);
+        shared = parse_shared_strings(xml);
+    }
+
+    std::string errors[3];
+    auto read_sheet = [&](size_t s) {
+        std::string sheet_xml;
+        if (zip.extract(sheet_paths[s], sheet_xml, errors[s])) sheets[s] = parse_xlsx_sheet(sheet_xml, shared);
+    };
+    std::vector<std::thread> readers;
+    for (size_t s = 1; s < sheet_paths.size(); ++s) readers.emplace_back(read_sheet, s);
+    read_sheet(0);
+    for (auto& t : readers) t.join();
+    for (const auto& e : errors)
+        if (!e.empty()) return fail(e);
+    return true;
+}
+
+/// Parse MiGeL items straight from the workbook (see parse_migel_items()). Returns no
+/// items if the workbook cannot be read.
+inline std::vector<MigelItem> parse_migel_xlsx(TokenDict& tokens, const std::string& path) {
+    std::array<SheetRows, 3> sheets;
+    if (!read_xlsx_sheets(path, sheets)) return {};
+    return build_migel_items(tokens, sheets);
+}
+
+} // namespace migel